@@ -0,0 +1,44 @@
+/**
+ * Michał Kuźba, Bartosz Bruski, Jakub Kuklis
+ *
+ * Read-only view of the sorted catalog laid out as a single text.
+ */
+
+#ifndef CATALOG_VIEW_H
+#define CATALOG_VIEW_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "stamp.h"
+
+/**
+ * Number of entries of the year offset table: one per correct year
+ * and one marking the end of the text.
+ */
+const int year_slots = last_year - first_year + 2;
+
+/**
+ * Output lines of the sorted stamps, one after another, each ended
+ * with a newline. The lines of the stamps from year y start at
+ * text + offset[y - first_year], so the answer to any range query
+ * is one contiguous slice of the text. Intervals are clamped to the
+ * correct years before the offsets are looked up.
+ */
+struct catalog_view {
+  const char *text;
+  const uint64_t *offset;
+
+  const char *begin(paII interval) const {
+    interval = clamp_interval(interval);
+    return text + offset[interval.first - first_year];
+  }
+
+  size_t length(paII interval) const {
+    interval = clamp_interval(interval);
+    return offset[interval.second + 1 - first_year] -
+           offset[interval.first - first_year];
+  }
+};
+
+#endif /* CATALOG_VIEW_H */
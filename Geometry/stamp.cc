@@ -0,0 +1,267 @@
+/**
+ * Michał Kuźba, Bartosz Bruski, Jakub Kuklis
+ *
+ * Our assumption is that correct years are in (1000,2999) range.
+ * We consider "Stamp 1000 1000 1000" to be a correct stamp,
+ * with value=1000, year=1000 and post="1000".
+ */
+
+#include <algorithm>
+#include <regex>
+
+#include "stamp.h"
+
+using std::string;
+using std::max;
+using std::min;
+using std::make_pair;
+using std::vector;
+using std::regex;
+using std::regex_match;
+using std::regex_search;
+using std::regex_replace;
+using std::smatch;
+
+/**
+ * Constant variables used in function parse()
+ * to denote an incorrect line.
+ */
+const stamp error_stamp = {0, 0, 0, "", ""};
+const paBT error_pair = make_pair(false, error_stamp);
+
+post_id post_pool::intern(const string &post) {
+  auto it = ids.find(post);
+  if (it != ids.end())
+    return it->second;
+
+  post_id id = names.size();
+  names.push_back(post);
+  ids.emplace(post, id);
+  return id;
+}
+
+bool post_pool::find(const string &post, post_id &id) const {
+  auto it = ids.find(post);
+  if (it == ids.end())
+    return false;
+  id = it->second;
+  return true;
+}
+
+const string &post_pool::name(post_id id) const {
+  return names[id];
+}
+
+size_t post_pool::size() const {
+  return names.size();
+}
+
+const vector<uint32_t> &post_pool::ranks() const {
+  if (rank.size() != names.size()) {
+    vector<post_id> order(names.size());
+    for (post_id id = 0; id < order.size(); ++id)
+      order[id] = id;
+    sort(order.begin(), order.end(),
+         [this](post_id a, post_id b) { return names[a] < names[b]; });
+
+    rank.resize(names.size());
+    for (uint32_t i = 0; i < order.size(); ++i)
+      rank[order[i]] = i;
+  }
+  return rank;
+}
+
+void append_output_line(string &out, const stamp &s, const post_pool &posts) {
+  out += std::to_string(s.year);
+  out += ' ';
+  out += posts.name(s.post);
+  out += ' ';
+  out += s.value_text;
+  out += ' ';
+  out += s.name;
+}
+
+string clear_empty_space(string text) {
+  static const regex re("\\s+");
+  return regex_replace(text, re, " ");
+}
+
+bool is_range(string line) {
+  static const regex re("(\\s*)([0-9]{4})(\\s+)([0-9]{4})(\\s*)");
+
+  smatch m;
+
+  bool match = regex_match(line, m, re);
+
+  if (!match) {
+    return false;
+  }
+
+  int left, right;
+
+  left = stoi(m[2]);
+  right = stoi(m[4]);
+
+  if (left > right)
+    return false;
+
+  return true;
+}
+
+bool is_year(int year_cand) {
+  return (first_year <= year_cand && year_cand <= last_year);
+}
+
+paBT parse(string line, post_pool &posts) {
+  bool found = false;
+  string name, value, post;
+  int year_num;
+  long double value_num;
+
+  // Regexes to match consecutively: release year, prefix ending
+  // before the year and suffix starting after the year.
+  smatch year_sm;
+  static const regex year_re("(\\s+)([0-9]{4})");
+
+  smatch pref_sm;
+  static const regex pref_re("(\\s*)(.+?)(\\s+)([0-9]+[.,][0-9]+|[0-9]+)");
+
+  smatch suff_sm;
+  static const regex suff_re("(\\s+)(.+\\S)(\\s*)");
+
+  string str = line;
+
+  while (regex_search(str, year_sm, year_re)) {
+
+    int year_cand = stoi(year_sm[0]);
+    bool correct_year = is_year(year_cand);
+
+    // Prefix of line that ends before the year candidate
+    int curr_pref_length = year_sm.prefix().str().size();
+    string pref = line.substr(0, line.size() - str.size() + curr_pref_length);
+    bool correct_pref = regex_match(pref, pref_sm, pref_re);
+
+    string suff = year_sm.suffix().str();
+    bool correct_suff = regex_match(suff, suff_sm, suff_re);
+
+    if (correct_year && correct_pref && correct_suff) {
+      found = true;
+      name = clear_empty_space(pref_sm[2]);
+      value = pref_sm[4];
+      post = clear_empty_space(suff_sm[2]);
+      year_num = year_cand;
+    }
+
+    str = year_sm.suffix().str();
+  }
+
+  if (found) {
+    // Normalization of notation
+    static const regex comma_dot(",");
+    value_num = stold(regex_replace(value, comma_dot, "."));
+
+    stamp res = {year_num, posts.intern(post), value_num, name, value};
+
+    return make_pair(true, res);
+  }
+  return error_pair;
+}
+
+paII clamp_interval(paII interval) {
+  int from = max(interval.first, first_year);
+  int to = min(interval.second, last_year);
+  if (from > to)
+    return make_pair(first_year, first_year - 1);
+
+  return make_pair(from, to);
+}
+
+paII get_interval(string line) {
+  smatch year;
+
+  static const regex re("[0-9]{4}");
+
+  regex_search(line, year, re);
+  int from = stoi(year[0]);
+
+  string rest = year.suffix().str();
+
+  regex_search(rest, year, re);
+  int to = stoi(year[0]);
+
+  return clamp_interval(make_pair(from, to));
+}
+
+namespace {
+
+/**
+ * Parse a single condition of a filtered query into the filter.
+ */
+bool parse_condition(const string &condition, stamp_filter &filter) {
+  static const regex post_re("\\s*post\\s+(.*\\S)\\s*");
+  static const regex value_re(
+      "\\s*value\\s+([0-9]+(?:[.,][0-9]+)?)\\s+([0-9]+(?:[.,][0-9]+)?)\\s*");
+  static const regex name_re("\\s*name\\s+(.*\\S)\\s*");
+  static const regex comma_dot(",");
+
+  smatch m;
+  if (regex_match(condition, m, post_re) && !filter.by_post) {
+    filter.by_post = true;
+    filter.post = clear_empty_space(m[1]);
+  } else if (regex_match(condition, m, value_re) && !filter.by_value) {
+    filter.by_value = true;
+    filter.min_value = stold(regex_replace(m[1].str(), comma_dot, "."));
+    filter.max_value = stold(regex_replace(m[2].str(), comma_dot, "."));
+  } else if (regex_match(condition, m, name_re) && !filter.by_name) {
+    filter.by_name = true;
+    filter.name = clear_empty_space(m[1]);
+  } else {
+    return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+paBF parse_filter(string line) {
+  stamp_filter filter;
+
+  size_t bar = line.find('|');
+  if (bar == string::npos || !is_range(line.substr(0, bar)))
+    return make_pair(false, filter);
+
+  filter.interval = get_interval(line.substr(0, bar));
+
+  while (bar != string::npos) {
+    size_t next = line.find('|', bar + 1);
+    if (!parse_condition(line.substr(bar + 1, next - bar - 1), filter))
+      return make_pair(false, filter);
+    bar = next;
+  }
+
+  return make_pair(true, filter);
+}
+
+bool matches(const stamp &s, const stamp_filter &filter, const post_pool &posts) {
+  return filter.interval.first <= s.year && s.year <= filter.interval.second &&
+         (!filter.by_post || posts.name(s.post) == filter.post) &&
+         (!filter.by_value ||
+          (filter.min_value <= s.value && s.value <= filter.max_value)) &&
+         (!filter.by_name || s.name.find(filter.name) != string::npos);
+}
+
+paBA parse_aggregate(string line) {
+  static const regex re("\\s*(count|sum|max|posts)(\\s+[0-9]{4}\\s+[0-9]{4}\\s*)");
+  static const char *const kinds[] = {"count", "sum", "max", "posts"};
+
+  aggregate_query query{};
+  smatch m;
+  if (!regex_match(line, m, re) || !is_range(m[2]))
+    return make_pair(false, query);
+
+  for (int kind = aggregate_count; kind <= aggregate_posts; ++kind)
+    if (m[1] == kinds[kind])
+      query.kind = (aggregate_kind) kind;
+  query.interval = get_interval(m[2]);
+  return make_pair(true, query);
+}
@@ -0,0 +1,188 @@
+/**
+ * Michał Kuźba, Bartosz Bruski, Jakub Kuklis
+ *
+ * Representation of a single stamp and parsing of the input lines.
+ */
+
+#ifndef STAMP_H
+#define STAMP_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+typedef uint32_t post_id;
+
+/**
+ * Names of the posts, each stored once and referred to by its id.
+ * Real catalogs repeat a few hundred posts millions of times.
+ */
+class post_pool {
+ public:
+  /**
+   * @return id of the post, added to the pool if it is new
+   */
+  post_id intern(const std::string &post);
+
+  /**
+   * Look the post up without adding it.
+   * Returns false if the post is not in the pool.
+   */
+  bool find(const std::string &post, post_id &id) const;
+
+  const std::string &name(post_id id) const;
+
+  /**
+   * @return number of the posts in the pool
+   */
+  size_t size() const;
+
+  /**
+   * Position of every post in the alphabetical order of all posts,
+   * so that posts can be compared by their ids. Recomputed after
+   * new posts are added.
+   */
+  const std::vector<uint32_t> &ranks() const;
+
+ private:
+  std::vector<std::string> names;
+  std::unordered_map<std::string, post_id> ids;
+  mutable std::vector<uint32_t> rank;
+};
+
+/**
+ * Stamp is represented by its year, post, value and name. The value is
+ * also kept as written in the input, to be printed back the same way.
+ */
+struct stamp {
+  int year;
+  post_id post;
+  long double value;
+  std::string name;
+  std::string value_text;
+};
+
+/**
+ * Order of the stamps: by year, post, value and name.
+ */
+class stamp_less {
+ public:
+  explicit stamp_less(const post_pool &posts) : rank(posts.ranks()) {}
+
+  bool operator()(const stamp &a, const stamp &b) const {
+    if (a.year != b.year)
+      return a.year < b.year;
+    if (a.post != b.post)
+      return rank[a.post] < rank[b.post];
+    if (a.value != b.value)
+      return a.value < b.value;
+    int names = a.name.compare(b.name);
+    if (names != 0)
+      return names < 0;
+    return a.value_text < b.value_text;
+  }
+
+ private:
+  const std::vector<uint32_t> &rank;
+};
+
+/**
+ * Append the line printed for the stamp: year, post, value and name.
+ */
+void append_output_line(std::string &out, const stamp &s, const post_pool &posts);
+
+typedef std::pair<int, int> paII;
+typedef std::pair<bool, stamp> paBT;
+
+/**
+ * Bounds of the correct years, inclusive.
+ */
+const int first_year = 1000;
+const int last_year = 2999;
+
+/**
+ * Replace multiple space with one.
+ */
+std::string clear_empty_space(std::string text);
+
+/**
+ * Check if the given string contains a correct range of years.
+ */
+bool is_range(std::string line);
+
+bool is_year(int year_cand);
+
+/**
+ * Parse a line with information about stamps. The post of the stamp
+ * is interned in the given pool.
+ * Returns a pair - (correctnes of the input, stamp).
+ */
+paBT parse(std::string line, post_pool &posts);
+
+/**
+ * Narrow the interval to the correct years; if none of them is inside,
+ * the returned interval is empty (first > second).
+ */
+paII clamp_interval(paII interval);
+
+/**
+ * Returns the year interval. Function assumes the line includes a correct
+ * range. The interval is narrowed to the correct years (see clamp_interval).
+ */
+paII get_interval(std::string line);
+
+/**
+ * Conditions of a filtered query. Only the conditions with the
+ * corresponding flag set are checked, the interval always is.
+ */
+struct stamp_filter {
+  paII interval;
+  bool by_post = false;
+  std::string post;
+  bool by_value = false;
+  long double min_value = 0, max_value = 0;
+  bool by_name = false;
+  std::string name;
+};
+
+typedef std::pair<bool, stamp_filter> paBF;
+
+/**
+ * Parse a filtered query: a correct range followed by conditions,
+ * each preceded by '|':
+ *   post POST        - the post is exactly POST,
+ *   value MIN MAX    - the value is in [MIN, MAX],
+ *   name TEXT        - the name contains TEXT.
+ * Returns a pair - (correctness of the input, filter).
+ */
+paBF parse_filter(std::string line);
+
+/**
+ * Check if the stamp satisfies all conditions of the filter.
+ */
+bool matches(const stamp &s, const stamp_filter &filter, const post_pool &posts);
+
+enum aggregate_kind {
+  aggregate_count,  // number of the stamps
+  aggregate_sum,    // total value of the stamps
+  aggregate_max,    // maximal value of a stamp
+  aggregate_posts   // number of distinct posts
+};
+
+struct aggregate_query {
+  aggregate_kind kind;
+  paII interval;
+};
+
+typedef std::pair<bool, aggregate_query> paBA;
+
+/**
+ * Parse an aggregate query: "count", "sum", "max" or "posts"
+ * followed by a correct range.
+ * Returns a pair - (correctness of the input, query).
+ */
+paBA parse_aggregate(std::string line);
+
+#endif /* STAMP_H */
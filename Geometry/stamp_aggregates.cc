@@ -0,0 +1,230 @@
+/**
+ * Michał Kuźba, Bartosz Bruski, Jakub Kuklis
+ */
+
+#include <algorithm>
+#include <limits>
+#include <sstream>
+
+#include "catalog_view.h"
+#include "stamp_aggregates.h"
+
+using std::string;
+using std::vector;
+using std::make_pair;
+
+namespace {
+
+/**
+ * @return number of the digits after the separator of the value as written
+ */
+int fraction_digits_of(const string &text) {
+  size_t separator = text.find_first_of(".,");
+  return separator == string::npos ? 0 : text.size() - separator - 1;
+}
+
+/**
+ * Append the digit to the value, unless it would not fit 64 bits.
+ */
+bool push_digit(uint64_t &value, int digit) {
+  if (value > (std::numeric_limits<uint64_t>::max() - digit) / 10)
+    return false;
+  value = value * 10 + digit;
+  return true;
+}
+
+/**
+ * Compute the value as written, scaled by 10^digits.
+ * @return whether it fits 64 bits
+ */
+bool scaled_value(const string &text, int digits, uint64_t &scaled) {
+  scaled = 0;
+  int fraction = 0;
+  bool separated = false;
+  for (char c : text) {
+    if (c == '.' || c == ',') {
+      separated = true;
+    } else if ('0' <= c && c <= '9') {
+      if (!push_digit(scaled, c - '0'))
+        return false;
+      fraction += separated;
+    } else {
+      return false;
+    }
+  }
+  for (; fraction < digits; ++fraction)
+    if (!push_digit(scaled, 0))
+      return false;
+  return true;
+}
+
+/**
+ * @return the scaled value written in decimal, without the trailing
+ * zeros of its fraction, like long double values are printed
+ */
+string decimal(uint64_t scaled, int digits) {
+  string text = std::to_string(scaled);
+  if (digits == 0)
+    return text;
+
+  if (text.size() <= (size_t) digits)
+    text.insert(0, digits + 1 - text.size(), '0');
+  text.insert(text.size() - digits, 1, '.');
+  while (text.back() == '0')
+    text.pop_back();
+  if (text.back() == '.')
+    text.pop_back();
+  return text;
+}
+
+}  // namespace
+
+stamp_aggregates::stamp_aggregates(const stamp_index &stamps)
+    : count_prefix(year_slots, 0), fraction_digits(0), exact(true),
+      scaled_prefix(year_slots, 0), sum_prefix(year_slots, 0), year_number(year_slots, 0) {
+  const int years = last_year - first_year + 1;
+  vector<long double> year_max(years, -1);
+  vector<vector<uint32_t>> year_posts(years);
+
+  stamps.for_each_in(make_pair(first_year, last_year), [&](const stamp &s) {
+    fraction_digits = std::max(fraction_digits, fraction_digits_of(s.value_text));
+  });
+
+  for (int year = first_year; year <= last_year; ++year) {
+    int y = year - first_year;
+    uint64_t count = 0;
+    uint64_t scaled_sum = 0;
+    long double sum = 0;
+    stamps.for_each_in(make_pair(year, year), [&](const stamp &s) {
+      uint64_t scaled;
+      count++;
+      sum += s.value;
+      if (exact && scaled_value(s.value_text, fraction_digits, scaled) &&
+          scaled <= std::numeric_limits<uint64_t>::max() - scaled_prefix[y] - scaled_sum)
+        scaled_sum += scaled;
+      else
+        exact = false;
+      year_max[y] = std::max(year_max[y], s.value);
+      // Stamps of a year are sorted by post.
+      if (year_posts[y].empty() || year_posts[y].back() != s.post)
+        year_posts[y].push_back(s.post);
+    });
+
+    count_prefix[y + 1] = count_prefix[y] + count;
+    scaled_prefix[y + 1] = scaled_prefix[y] + scaled_sum;
+    sum_prefix[y + 1] = sum_prefix[y] + sum;
+    year_number[y] = years_with_stamps.size();
+    if (count > 0)
+      years_with_stamps.push_back(year);
+  }
+  year_number[years] = years_with_stamps.size();
+
+  max_table.push_back(year_max);
+  for (int length = 2; length <= years; length *= 2) {
+    const vector<long double> &previous = max_table.back();
+    vector<long double> level(years - length + 1);
+    for (int y = 0; y + length <= years; ++y)
+      level[y] = std::max(previous[y], previous[y + length / 2]);
+    max_table.push_back(level);
+  }
+
+  // Posts are counted in the years numbered [j, i] by their occurrences
+  // whose previous occurrence of the same post is before j. Going with j
+  // from left to right, fresh[t] is the number of such occurrences in t.
+  uint32_t numbered = years_with_stamps.size();
+  vector<int> last_seen(stamps.posts().size(), -1);
+  vector<uint32_t> fresh(numbered, 0);
+  vector<vector<uint32_t>> seen_again_after(numbered);
+  for (uint32_t t = 0; t < numbered; ++t) {
+    for (post_id post : year_posts[years_with_stamps[t] - first_year]) {
+      if (last_seen[post] < 0)
+        fresh[t]++;
+      else
+        seen_again_after[last_seen[post]].push_back(t);
+      last_seen[post] = t;
+    }
+  }
+
+  distinct.resize((size_t) numbered * (numbered + 1) / 2);
+  for (uint32_t j = 0; j < numbered; ++j) {
+    if (j > 0)
+      for (uint32_t t : seen_again_after[j - 1])
+        fresh[t]++;
+    uint32_t total = 0;
+    for (uint32_t i = j; i < numbered; ++i) {
+      total += fresh[i];
+      distinct[(size_t) i * (i + 1) / 2 + j] = total;
+    }
+  }
+}
+
+uint64_t stamp_aggregates::count(paII interval) const {
+  if (interval.first > interval.second)
+    return 0;
+  return count_prefix[interval.second + 1 - first_year] -
+         count_prefix[interval.first - first_year];
+}
+
+string stamp_aggregates::sum(paII interval) const {
+  if (interval.first > interval.second)
+    return "0";
+  int from = interval.first - first_year, to = interval.second + 1 - first_year;
+  if (exact)
+    return decimal(scaled_prefix[to] - scaled_prefix[from], fraction_digits);
+
+  std::ostringstream out;
+  out.precision(std::numeric_limits<long double>::digits10);
+  out << sum_prefix[to] - sum_prefix[from];
+  return out.str();
+}
+
+long double stamp_aggregates::max(paII interval) const {
+  if (interval.first > interval.second)
+    return -1;
+  int from = interval.first - first_year;
+  int length = interval.second - interval.first + 1;
+  int level = 0;
+  while ((2 << level) <= length)
+    level++;
+  return std::max(max_table[level][from],
+                  max_table[level][from + length - (1 << level)]);
+}
+
+uint32_t stamp_aggregates::posts(paII interval) const {
+  if (interval.first > interval.second)
+    return 0;
+  uint32_t j = year_number[interval.first - first_year];
+  uint32_t end = year_number[interval.second + 1 - first_year];
+  if (j >= end)
+    return 0;
+  uint32_t i = end - 1;
+  return distinct[(size_t) i * (i + 1) / 2 + j];
+}
+
+string stamp_aggregates::answer(const aggregate_query &query) const {
+  std::ostringstream out;
+  out.precision(std::numeric_limits<long double>::digits10);
+
+  switch (query.kind) {
+    case aggregate_count:
+      out << count(query.interval);
+      break;
+    case aggregate_sum:
+      out << sum(query.interval);
+      break;
+    case aggregate_max:
+      if (count(query.interval) == 0)
+        out << "none";
+      else
+        out << max(query.interval);
+      break;
+    case aggregate_posts:
+      out << posts(query.interval);
+      break;
+  }
+  return out.str();
+}
+
+size_t stamp_aggregates::size() const {
+  return count_prefix.back();
+}
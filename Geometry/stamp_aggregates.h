@@ -0,0 +1,85 @@
+/**
+ * Michał Kuźba, Bartosz Bruski, Jakub Kuklis
+ *
+ * Aggregates of the stamps over ranges of years.
+ */
+
+#ifndef STAMP_AGGREGATES_H
+#define STAMP_AGGREGATES_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "stamp.h"
+#include "stamp_index.h"
+
+/**
+ * Tables built once from the sorted stamps, answering every aggregate
+ * query in constant time:
+ *   - prefix sums over years of the number and the total value, the
+ *     latter exact: values as written scaled to integers,
+ *   - a sparse table of the maximal values of the years,
+ *   - the number of distinct posts for every pair of years that have
+ *     stamps, filled in with one sweep over the (year, post) pairs.
+ */
+class stamp_aggregates {
+ public:
+  explicit stamp_aggregates(const stamp_index &stamps);
+
+  /**
+   * @return the answer to the query, as printed
+   */
+  std::string answer(const aggregate_query &query) const;
+
+  /**
+   * @return number of the stamps the tables were built from
+   */
+  size_t size() const;
+
+ private:
+  uint64_t count(paII interval) const;
+
+  /**
+   * Total value, as printed.
+   */
+  std::string sum(paII interval) const;
+
+  /**
+   * Maximal value, or -1 if there are no stamps in the interval.
+   */
+  long double max(paII interval) const;
+  uint32_t posts(paII interval) const;
+
+  std::vector<uint64_t> count_prefix;
+
+  /**
+   * Values are summed exactly as integers scaled by 10^fraction_digits,
+   * the largest number of digits after the separator of a value. If the
+   * total does not fit 64 bits, the sums are long double instead.
+   */
+  int fraction_digits;
+  bool exact;
+  std::vector<uint64_t> scaled_prefix;
+  std::vector<long double> sum_prefix;
+
+  /**
+   * max_table[k][y] is the maximal value in years [y, y + 2^k).
+   */
+  std::vector<std::vector<long double>> max_table;
+
+  /**
+   * Years having stamps, numbered from 0; year_number[y] is the number
+   * of the first such year not earlier than y.
+   */
+  std::vector<int> years_with_stamps;
+  std::vector<uint32_t> year_number;
+
+  /**
+   * distinct[i * (i + 1) / 2 + j] is the number of distinct posts in the
+   * years numbered [j, i].
+   */
+  std::vector<uint32_t> distinct;
+};
+
+#endif /* STAMP_AGGREGATES_H */
@@ -0,0 +1,138 @@
+/**
+ * Michał Kuźba, Bartosz Bruski, Jakub Kuklis
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <thread>
+
+#include "stamp_batch.h"
+#include "stamp_stats.h"
+
+using std::string;
+using std::vector;
+using std::make_pair;
+using std::min;
+using std::max;
+using std::thread;
+
+namespace {
+
+/**
+ * Upper bound on the size of the output assembled in memory at once.
+ */
+const size_t chunk_bytes = 64 << 20;
+
+/**
+ * Outputs smaller than this are copied by a single thread.
+ */
+const size_t parallel_bytes = 1 << 20;
+
+/**
+ * Copy the answers to queries [from, to) into buffer, the answer
+ * to the query i starting at position pos[i - from].
+ */
+void copy_answers(const catalog_view &catalog, const vector<paII> &queries,
+                  size_t from, size_t to, const size_t *pos, char *buffer) {
+  for (size_t i = from; i < to; ++i)
+    memcpy(buffer + pos[i - from], catalog.begin(queries[i]),
+           catalog.length(queries[i]));
+}
+
+}  // namespace
+
+catalog_text make_catalog_text(const stamp_index &stamps) {
+  catalog_text catalog;
+  catalog.offset.resize(year_slots);
+
+  size_t total = 0;
+  stamps.for_each_in(make_pair(first_year, last_year), [&total, &stamps](const stamp &s) {
+    // Year, post, value and name, separated with spaces and ended with '\n'.
+    total += 4 + stamps.posts().name(s.post).size() + s.value_text.size() +
+             s.name.size() + 4;
+  });
+  catalog.text.reserve(total);
+
+  for (int year = first_year; year <= last_year; ++year) {
+    catalog.offset[year - first_year] = catalog.text.size();
+    stamps.for_each_in(make_pair(year, year), [&catalog, &stamps](const stamp &s) {
+      append_output_line(catalog.text, s, stamps.posts());
+      catalog.text += '\n';
+    });
+  }
+  catalog.offset[last_year + 1 - first_year] = catalog.text.size();
+
+  return catalog;
+}
+
+void answer_batch(const catalog_view &catalog, const vector<paII> &queries,
+                  std::ostream &out) {
+  phase_timer timer(phase_output);
+  stamp_stats &s = stats();
+  size_t workers = max(1u, thread::hardware_concurrency());
+
+  vector<char> buffer;
+  vector<size_t> pos;
+  size_t first = 0;
+
+  while (first < queries.size()) {
+    // Answers too big for a chunk are written straight from the catalog.
+    size_t length = catalog.length(queries[first]);
+    if (length > chunk_bytes) {
+      out.write(catalog.begin(queries[first]), length);
+      if (s.enabled)
+        s.results += std::count(catalog.begin(queries[first]),
+                                catalog.begin(queries[first]) + length, '\n');
+      s.bytes_written += length;
+      first++;
+      continue;
+    }
+
+    pos.assign(1, 0);
+    size_t last = first;
+    while (last < queries.size()) {
+      length = catalog.length(queries[last]);
+      if (pos.back() + length > chunk_bytes)
+        break;
+      pos.push_back(pos.back() + length);
+      last++;
+    }
+
+    buffer.resize(pos.back());
+    size_t count = last - first;
+    size_t threads = pos.back() < parallel_bytes ? 1 : min(workers, count);
+
+    if (threads == 1) {
+      copy_answers(catalog, queries, first, last, pos.data(), buffer.data());
+    } else {
+      vector<thread> pool;
+      for (size_t t = 0; t < threads; ++t) {
+        size_t from = first + count * t / threads;
+        size_t to = first + count * (t + 1) / threads;
+        pool.emplace_back([&, from, to]() {
+          copy_answers(catalog, queries, from, to, pos.data() + (from - first),
+                       buffer.data());
+        });
+      }
+      for (thread &t : pool)
+        t.join();
+    }
+
+    out.write(buffer.data(), buffer.size());
+    if (s.enabled)
+      s.results += std::count(buffer.begin(), buffer.end(), '\n');
+    s.bytes_written += buffer.size();
+    first = last;
+  }
+
+  out.flush();
+}
+
+void answer_batch(const stamp_index &stamps, const vector<paII> &queries,
+                  std::ostream &out) {
+  phase_timer timer(phase_index);
+  catalog_text catalog = make_catalog_text(stamps);
+  timer.stop();
+  answer_batch(catalog.view(), queries, out);
+}
@@ -0,0 +1,42 @@
+/**
+ * Michał Kuźba, Bartosz Bruski, Jakub Kuklis
+ *
+ * Offline answering of many range queries at once.
+ */
+
+#ifndef STAMP_BATCH_H
+#define STAMP_BATCH_H
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "catalog_view.h"
+#include "stamp.h"
+#include "stamp_index.h"
+
+/**
+ * Catalog text built from the sorted stamps in memory.
+ */
+struct catalog_text {
+  std::string text;
+  std::vector<uint64_t> offset;
+
+  catalog_view view() const { return {text.data(), offset.data()}; }
+};
+
+catalog_text make_catalog_text(const stamp_index &stamps);
+
+/**
+ * Write the answers to all queries, in the order of the queries.
+ * The answer to a query is one contiguous slice of the catalog text;
+ * slices are copied to the output buffer by several threads.
+ */
+void answer_batch(const catalog_view &catalog, const std::vector<paII> &queries,
+                  std::ostream &out);
+
+void answer_batch(const stamp_index &stamps, const std::vector<paII> &queries,
+                  std::ostream &out);
+
+#endif /* STAMP_BATCH_H */
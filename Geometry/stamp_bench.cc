@@ -0,0 +1,166 @@
+/**
+ * Michał Kuźba, Bartosz Bruski, Jakub Kuklis
+ *
+ * Throughput benchmark of the stamp program.
+ *
+ * Usage: stamp_bench FILE
+ *
+ * FILE is an input of the stamp program, e.g. made with stamp_gen.
+ * Reports the speed of every phase: parsing the catalog, sorting it,
+ * answering the range queries one by one and in the batch mode, and
+ * compressing the catalog and answering the queries from it.
+ */
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#include "stamp.h"
+#include "stamp_batch.h"
+#include "stamp_compact.h"
+#include "stamp_index.h"
+
+using std::string;
+using std::vector;
+using std::cout;
+using std::cerr;
+using std::endl;
+
+namespace {
+
+typedef std::chrono::steady_clock bench_clock;
+
+double seconds_since(bench_clock::time_point start) {
+  return std::chrono::duration<double>(bench_clock::now() - start).count();
+}
+
+/**
+ * Output that only counts the written bytes.
+ */
+class counting_buffer : public std::streambuf {
+ public:
+  size_t bytes = 0;
+
+ protected:
+  int_type overflow(int_type c) override {
+    bytes++;
+    return traits_type::not_eof(c);
+  }
+
+  std::streamsize xsputn(const char *, std::streamsize n) override {
+    bytes += n;
+    return n;
+  }
+};
+
+void report(const string &phase, double time, double count, const string &unit) {
+  cout << std::left << std::setw(16) << phase << std::right << std::fixed
+       << std::setprecision(3) << std::setw(10) << time << " s"
+       << std::setprecision(1) << std::setw(16) << (time > 0 ? count / time : 0)
+       << " " << unit << "/s" << endl;
+}
+
+const double megabyte = 1 << 20;
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  if (argc != 2) {
+    cerr << "Usage: " << argv[0] << " FILE" << endl;
+    return 1;
+  }
+
+  std::ifstream file(argv[1]);
+  if (!file) {
+    cerr << "Cannot open " << argv[1] << endl;
+    return 1;
+  }
+
+  vector<string> lines;
+  size_t input_bytes = 0;
+  string line;
+  while (getline(file, line)) {
+    input_bytes += line.size() + 1;
+    lines.push_back(line);
+  }
+
+  // Parsing, until the first query like in the stamp program.
+  stamp_index stamps;
+  size_t rejected = 0, parsed_bytes = 0, first_query = 0;
+  bench_clock::time_point start = bench_clock::now();
+  for (; first_query < lines.size() && !is_range(lines[first_query]); ++first_query) {
+    paBT p = parse(lines[first_query], stamps.posts());
+    if (p.first)
+      stamps.add(p.second);
+    else
+      rejected++;
+    parsed_bytes += lines[first_query].size() + 1;
+  }
+  double parse_time = seconds_since(start);
+
+  start = bench_clock::now();
+  stamps.sort();
+  double sort_time = seconds_since(start);
+
+  vector<paII> queries;
+  size_t incorrect = 0;
+  for (size_t i = first_query; i < lines.size(); ++i) {
+    if (is_range(lines[i]))
+      queries.push_back(get_interval(lines[i]));
+    else
+      incorrect++;
+  }
+
+  counting_buffer single_buffer;
+  std::ostream single(&single_buffer);
+  start = bench_clock::now();
+  for (const paII &interval : queries)
+    stamps.for_each_in(interval, [&single, &stamps](const stamp &p) {
+      string out;
+      append_output_line(out, p, stamps.posts());
+      single << out << '\n';
+    });
+  double query_time = seconds_since(start);
+
+  counting_buffer batch_buffer;
+  std::ostream batch(&batch_buffer);
+  start = bench_clock::now();
+  answer_batch(stamps, queries, batch);
+  double batch_time = seconds_since(start);
+
+  start = bench_clock::now();
+  compact_catalog compact(stamps);
+  double compact_time = seconds_since(start);
+
+  counting_buffer compact_buffer;
+  std::ostream compact_out(&compact_buffer);
+  size_t compact_lines = 0;
+  start = bench_clock::now();
+  for (const paII &interval : queries)
+    compact.write_lines(interval, compact_out, compact_lines);
+  double compact_query_time = seconds_since(start);
+
+  cout << "input:    " << lines.size() << " lines, " << input_bytes / megabyte << " MB" << endl;
+  cout << "stamps:   " << stamps.size() << " accepted, " << rejected << " rejected" << endl;
+  cout << "queries:  " << queries.size() << " correct, " << incorrect << " incorrect" << endl;
+  cout << "output:   " << single_buffer.bytes / megabyte << " MB" << endl;
+  cout << "compact:  " << compact.memory() / megabyte << " MB, "
+       << (stamps.size() > 0 ? (double) compact.memory() / stamps.size() : 0)
+       << " bytes per stamp" << endl;
+  report("parse", parse_time, first_query, "lines");
+  report("parse", parse_time, parsed_bytes / megabyte, "MB");
+  report("sort", sort_time, stamps.size(), "stamps");
+  report("query", query_time, queries.size(), "queries");
+  report("query output", query_time, single_buffer.bytes / megabyte, "MB");
+  report("batch", batch_time, queries.size(), "queries");
+  report("batch output", batch_time, batch_buffer.bytes / megabyte, "MB");
+  report("compact", compact_time, stamps.size(), "stamps");
+  report("compact query", compact_query_time, queries.size(), "queries");
+  report("compact output", compact_query_time, compact_buffer.bytes / megabyte, "MB");
+
+  return 0;
+}
@@ -0,0 +1,116 @@
+/**
+ * Michał Kuźba, Bartosz Bruski, Jakub Kuklis
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+#include "stamp_catalogs.h"
+#include "stamp_snapshot.h"
+#include "stamp_stats.h"
+
+using std::string;
+using std::vector;
+using std::cerr;
+using std::max;
+using std::min;
+using std::thread;
+
+namespace {
+
+/**
+ * Catalog of a single file. Errors are collected and printed after
+ * all files are loaded, so that messages of the threads do not mix.
+ */
+struct catalog_source {
+  stamp_index stamps;
+  bool loaded = false;
+  string errors;
+  size_t lines = 0;
+  size_t lines_rejected = 0;
+  size_t bytes_read = 0;
+};
+
+void load_text(const string &path, catalog_source &source) {
+  std::ifstream file(path);
+  if (!file) {
+    source.errors += "Cannot read catalog " + path + "\n";
+    return;
+  }
+
+  int line_number = 1;
+  string line;
+  while (getline(file, line)) {
+    source.lines++;
+    source.bytes_read += line.size() + 1;
+    paBT parsed = parse(line, source.stamps.posts());
+    if (parsed.first) {
+      source.stamps.add(parsed.second);
+    } else {
+      source.errors += "Error in line " + std::to_string(line_number) + " of " +
+                       path + ":" + line + "\n";
+      source.lines_rejected++;
+    }
+    line_number++;
+  }
+
+  if (file.bad()) {
+    source.errors += "Cannot read catalog " + path + "\n";
+    return;
+  }
+  source.stamps.sort();
+  source.loaded = true;
+}
+
+void load_snapshot(const string &path, catalog_source &source) {
+  stamp_snapshot snapshot;
+  source.loaded = snapshot.open(path, &source.errors) &&
+                  snapshot.load(source.stamps, &source.errors);
+}
+
+}  // namespace
+
+bool load_catalogs(const vector<string> &paths, stamp_index &stamps) {
+  vector<catalog_source> sources(paths.size());
+  {
+    phase_timer timer(phase_parse);
+    std::atomic<size_t> next(0);
+    auto work = [&paths, &sources, &next]() {
+      for (size_t i = next++; i < paths.size(); i = next++) {
+        if (is_snapshot(paths[i]))
+          load_snapshot(paths[i], sources[i]);
+        else
+          load_text(paths[i], sources[i]);
+      }
+    };
+
+    size_t workers = min<size_t>(paths.size(), max(1u, thread::hardware_concurrency()));
+    vector<thread> threads;
+    for (size_t i = 1; i < workers; ++i)
+      threads.emplace_back(work);
+    work();
+    for (thread &t : threads)
+      t.join();
+  }
+
+  bool loaded = true;
+  vector<stamp_index> indexes;
+  indexes.reserve(sources.size());
+  for (catalog_source &source : sources) {
+    cerr << source.errors;
+    loaded = loaded && source.loaded;
+    stats().lines += source.lines;
+    stats().lines_rejected += source.lines_rejected;
+    stats().bytes_read += source.bytes_read;
+    indexes.push_back(std::move(source.stamps));
+  }
+  if (!loaded)
+    return false;
+
+  phase_timer timer(phase_sort);
+  stamps.merge(indexes);
+  return true;
+}
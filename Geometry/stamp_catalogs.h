@@ -0,0 +1,27 @@
+/**
+ * Michał Kuźba, Bartosz Bruski, Jakub Kuklis
+ *
+ * Loading of the catalog from several files.
+ */
+
+#ifndef STAMP_CATALOGS_H
+#define STAMP_CATALOGS_H
+
+#include <string>
+#include <vector>
+
+#include "stamp_index.h"
+
+/**
+ * Load the stamps of all given files into the empty index, sorted.
+ *
+ * A file is either a snapshot (see stamp_snapshot.h) or stamp lines
+ * like those of the input. The files are loaded in parallel, each
+ * into its own index, and the sorted indexes are merged, so a catalog
+ * kept as a snapshot is never parsed or sorted again.
+ * Incorrect lines are reported with the name of their file.
+ * Returns false if some file could not be read.
+ */
+bool load_catalogs(const std::vector<std::string> &paths, stamp_index &stamps);
+
+#endif /* STAMP_CATALOGS_H */
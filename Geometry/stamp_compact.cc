@@ -0,0 +1,197 @@
+/**
+ * Michał Kuźba, Bartosz Bruski, Jakub Kuklis
+ */
+
+#include <algorithm>
+
+#include "catalog_view.h"
+#include "stamp_compact.h"
+
+using std::string;
+using std::vector;
+using std::make_pair;
+
+namespace {
+
+/**
+ * Kinds of the value separator, kept in the low bits of the first
+ * varint of a value.
+ */
+enum value_kind {
+  value_integer,  // no separator
+  value_dot,
+  value_comma,
+  value_text      // stored as written
+};
+
+/**
+ * Values with more digits do not fit in 64 bits.
+ */
+const size_t max_value_digits = 19;
+
+/**
+ * Output is written in pieces of this size.
+ */
+const size_t flush_bytes = 64 << 10;
+
+void put_varint(string &out, uint64_t x) {
+  while (x >= 0x80) {
+    out += (char) (x | 0x80);
+    x >>= 7;
+  }
+  out += (char) x;
+}
+
+uint64_t get_varint(const char *&p) {
+  uint64_t x = 0;
+  for (int shift = 0;; shift += 7) {
+    unsigned char byte = *p++;
+    x |= (uint64_t) (byte & 0x7f) << shift;
+    if (byte < 0x80)
+      return x;
+  }
+}
+
+void put_value(string &out, const string &value) {
+  size_t separator = value.find_first_of(".,");
+  size_t digits = value.size() - (separator == string::npos ? 0 : 1);
+  bool numeric = !value.empty() && digits <= max_value_digits &&
+                 separator != 0 && separator + 1 != value.size() &&
+                 std::all_of(value.begin(), value.end(), [](char c) {
+                   return ('0' <= c && c <= '9') || c == '.' || c == ',';
+                 }) &&
+                 (separator == string::npos ||
+                  value.find_first_of(".,", separator + 1) == string::npos);
+  if (!numeric) {
+    put_varint(out, value_text);
+    put_varint(out, value.size());
+    out += value;
+    return;
+  }
+
+  uint64_t number = 0;
+  for (char c : value)
+    if (c != '.' && c != ',')
+      number = 10 * number + (c - '0');
+
+  if (separator == string::npos) {
+    put_varint(out, (uint64_t) value.size() << 2 | value_integer);
+  } else {
+    value_kind kind = value[separator] == '.' ? value_dot : value_comma;
+    put_varint(out, (uint64_t) separator << 2 | kind);
+    put_varint(out, value.size() - separator - 1);
+  }
+  put_varint(out, number);
+}
+
+void append_value(string &out, const char *&p) {
+  uint64_t head = get_varint(p);
+  value_kind kind = (value_kind) (head & 3);
+  if (kind == value_text) {
+    uint64_t length = get_varint(p);
+    out.append(p, length);
+    p += length;
+    return;
+  }
+
+  size_t before = head >> 2;
+  size_t after = kind == value_integer ? 0 : get_varint(p);
+  uint64_t number = get_varint(p);
+
+  char digits[max_value_digits];
+  for (size_t i = before + after; i > 0; --i) {
+    digits[i - 1] = '0' + number % 10;
+    number /= 10;
+  }
+  out.append(digits, before);
+  if (kind != value_integer) {
+    out += kind == value_dot ? '.' : ',';
+    out.append(digits + before, after);
+  }
+}
+
+}  // namespace
+
+compact_catalog::compact_catalog(const stamp_index &stamps)
+    : offset(year_slots), count(stamps.size()) {
+  const post_pool &pool = stamps.posts();
+  const vector<uint32_t> &rank = pool.ranks();
+  posts.resize(pool.size());
+  for (post_id id = 0; id < pool.size(); ++id)
+    posts[rank[id]] = pool.name(id);
+
+  for (int year = first_year; year <= last_year; ++year) {
+    offset[year - first_year] = data.size();
+    const string *previous = nullptr;
+    stamps.for_each_in(make_pair(year, year), [this, &rank, &previous](const stamp &s) {
+      put_varint(data, rank[s.post]);
+      put_value(data, s.value_text);
+
+      size_t common = 0;
+      if (previous != nullptr) {
+        size_t limit = std::min(previous->size(), s.name.size());
+        while (common < limit && (*previous)[common] == s.name[common])
+          common++;
+      }
+      put_varint(data, common);
+      put_varint(data, s.name.size() - common);
+      data.append(s.name, common, string::npos);
+      previous = &s.name;
+    });
+  }
+  offset[year_slots - 1] = data.size();
+  data.shrink_to_fit();
+}
+
+size_t compact_catalog::size() const {
+  return count;
+}
+
+size_t compact_catalog::memory() const {
+  size_t bytes = sizeof(*this) + data.capacity() +
+                 offset.capacity() * sizeof(uint64_t) +
+                 posts.capacity() * sizeof(string);
+  for (const string &post : posts)
+    bytes += post.capacity();
+  return bytes;
+}
+
+size_t compact_catalog::write_lines(paII interval, std::ostream &out,
+                                    size_t &lines) const {
+  string buffer, name;
+  size_t bytes = 0;
+
+  for (int year = interval.first; year <= interval.second; ++year) {
+    const char *p = data.data() + offset[year - first_year];
+    const char *end = data.data() + offset[year + 1 - first_year];
+    string year_text = std::to_string(year);
+    name.clear();
+
+    while (p < end) {
+      buffer += year_text;
+      buffer += ' ';
+      buffer += posts[get_varint(p)];
+      buffer += ' ';
+      append_value(buffer, p);
+      buffer += ' ';
+
+      uint64_t common = get_varint(p);
+      uint64_t rest = get_varint(p);
+      name.resize(common);
+      name.append(p, rest);
+      p += rest;
+      buffer += name;
+      buffer += '\n';
+      lines++;
+
+      if (buffer.size() >= flush_bytes) {
+        out.write(buffer.data(), buffer.size());
+        bytes += buffer.size();
+        buffer.clear();
+      }
+    }
+  }
+
+  out.write(buffer.data(), buffer.size());
+  return bytes + buffer.size();
+}
@@ -0,0 +1,62 @@
+/**
+ * Michał Kuźba, Bartosz Bruski, Jakub Kuklis
+ *
+ * Catalog compressed in memory, decoded only for the queried years.
+ */
+
+#ifndef STAMP_COMPACT_H
+#define STAMP_COMPACT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "stamp.h"
+#include "stamp_index.h"
+
+/**
+ * The stamps of every year are encoded one after another in the sorted
+ * order, and the year is kept only in the offset table. A stamp is:
+ *   - its post as a varint index into the sorted dictionary of posts,
+ *   - its value as written: the number of digits before the separator
+ *     and the kind of the separator, the number of digits after it and
+ *     all digits as one varint (the text itself if it is too long),
+ *   - its name front-coded against the name of the previous stamp of
+ *     the year: varints with the length of the common prefix and of the
+ *     rest, followed by the rest.
+ * Lines are built from these only when a query needs them.
+ */
+class compact_catalog {
+ public:
+  /**
+   * Encode the sorted stamps.
+   */
+  explicit compact_catalog(const stamp_index &stamps);
+
+  /**
+   * @return number of the stamps in the catalog
+   */
+  size_t size() const;
+
+  /**
+   * @return bytes of memory held by the catalog
+   */
+  size_t memory() const;
+
+  /**
+   * Write the output lines of the stamps from the given time interval,
+   * adding their number to lines.
+   * @return number of the written bytes
+   */
+  size_t write_lines(paII interval, std::ostream &out, size_t &lines) const;
+
+ private:
+  std::vector<std::string> posts;
+  std::string data;
+  std::vector<uint64_t> offset;
+  size_t count;
+};
+
+#endif /* STAMP_COMPACT_H */
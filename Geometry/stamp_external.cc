@@ -0,0 +1,381 @@
+/**
+ * Michał Kuźba, Bartosz Bruski, Jakub Kuklis
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <queue>
+
+#include <unistd.h>
+
+#include "stamp_external.h"
+#include "stamp_snapshot.h"
+#include "stamp_stats.h"
+
+using std::string;
+using std::vector;
+using std::cerr;
+using std::endl;
+using std::make_pair;
+using std::min;
+using std::max;
+using std::unique_ptr;
+
+namespace {
+
+/**
+ * Maximal number of runs merged at once. More runs are merged
+ * in several passes, so that few files are open at a time.
+ */
+const size_t merge_fan_in = 64;
+
+/**
+ * Bounds of the buffer of a single file during the merge.
+ */
+const size_t min_buffer_bytes = 4 << 10;
+const size_t max_buffer_bytes = 1 << 20;
+
+/**
+ * Stamp as stored in a run: with the post spelled out, because
+ * every run is parsed with its own pool of posts.
+ */
+struct run_record {
+  int32_t year;
+  long double value;
+  string post;
+  string name;
+  string value_text;
+};
+
+/**
+ * Same order as stamp_less, with the posts compared by their names.
+ */
+bool record_less(const run_record &a, const run_record &b) {
+  if (a.year != b.year)
+    return a.year < b.year;
+  int posts = a.post.compare(b.post);
+  if (posts != 0)
+    return posts < 0;
+  if (a.value != b.value)
+    return a.value < b.value;
+  int names = a.name.compare(b.name);
+  if (names != 0)
+    return names < 0;
+  return a.value_text < b.value_text;
+}
+
+void write_string(std::ostream &out, const string &s) {
+  uint32_t length = s.size();
+  out.write(reinterpret_cast<const char *>(&length), sizeof(length));
+  out.write(s.data(), length);
+}
+
+bool read_string(std::istream &in, string &s) {
+  uint32_t length;
+  if (!in.read(reinterpret_cast<char *>(&length), sizeof(length)))
+    return false;
+  s.resize(length);
+  return (bool) in.read(&s[0], length);
+}
+
+void write_record(std::ostream &out, int32_t year, long double value,
+                  const string &post, const string &name, const string &value_text) {
+  out.write(reinterpret_cast<const char *>(&year), sizeof(year));
+  out.write(reinterpret_cast<const char *>(&value), sizeof(value));
+  write_string(out, post);
+  write_string(out, name);
+  write_string(out, value_text);
+}
+
+bool read_record(std::istream &in, run_record &r) {
+  return in.read(reinterpret_cast<char *>(&r.year), sizeof(r.year)) &&
+         in.read(reinterpret_cast<char *>(&r.value), sizeof(r.value)) &&
+         read_string(in, r.post) && read_string(in, r.name) &&
+         read_string(in, r.value_text);
+}
+
+/**
+ * Output line of the stamp, the same as append_output_line gives.
+ */
+void append_output_line(string &out, const run_record &r) {
+  out += std::to_string(r.year);
+  out += ' ';
+  out += r.post;
+  out += ' ';
+  out += r.value_text;
+  out += ' ';
+  out += r.name;
+}
+
+/**
+ * Bytes of the heap memory held by the string, if it does not fit
+ * in the string itself.
+ */
+size_t heap_bytes(const string &s) {
+  return s.capacity() < sizeof(string) ? 0 : s.capacity() + 1;
+}
+
+/**
+ * Run file read sequentially through its own buffer.
+ */
+class run_reader {
+ public:
+  run_reader(const string &path, size_t buffer_size) : buffer(buffer_size) {
+    file.rdbuf()->pubsetbuf(buffer.data(), buffer.size());
+    file.open(path, std::ios::binary);
+  }
+
+  bool next() { return read_record(file, record); }
+
+  vector<char> buffer;
+  std::ifstream file;
+  run_record record;
+};
+
+/**
+ * Call emit on the records of all runs in the sorted order.
+ * Returns false if some run could not be read.
+ */
+template <typename F>
+bool merge_runs(const vector<string> &paths, size_t buffer_size, F emit) {
+  vector<unique_ptr<run_reader>> readers;
+  for (const string &path : paths) {
+    readers.emplace_back(new run_reader(path, buffer_size));
+    if (!readers.back()->file.is_open()) {
+      cerr << "Cannot read run " << path << endl;
+      return false;
+    }
+  }
+
+  auto greater = [&readers](size_t a, size_t b) {
+    return record_less(readers[b]->record, readers[a]->record);
+  };
+  std::priority_queue<size_t, vector<size_t>, decltype(greater)> heap(greater);
+  for (size_t i = 0; i < readers.size(); ++i)
+    if (readers[i]->next())
+      heap.push(i);
+
+  while (!heap.empty()) {
+    size_t i = heap.top();
+    heap.pop();
+    emit(readers[i]->record);
+    if (readers[i]->next())
+      heap.push(i);
+  }
+
+  for (size_t i = 0; i < readers.size(); ++i) {
+    if (readers[i]->file.bad() || !readers[i]->file.eof()) {
+      cerr << "Cannot read run " << paths[i] << endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * Create an empty file in the directory and return its path,
+ * or an empty string if it could not be created.
+ */
+string temporary_file(const string &dir, const string &kind) {
+  string path = dir + "/znaczki-" + kind + "-XXXXXX";
+  int fd = mkstemp(&path[0]);
+  if (fd < 0) {
+    cerr << "Cannot create a temporary file in " << dir << endl;
+    return "";
+  }
+  close(fd);
+  return path;
+}
+
+}  // namespace
+
+external_sorter::external_sorter(const string &dir, size_t memory_limit)
+    : dir(dir),
+      memory_limit(memory_limit),
+      current(new stamp_index),
+      current_bytes(0),
+      current_posts(0),
+      count(0),
+      temporary_catalog(false) {}
+
+external_sorter::~external_sorter() {
+  for (const string &run : runs)
+    remove(run.c_str());
+  if (temporary_catalog && !catalog.empty())
+    remove(catalog.c_str());
+}
+
+post_pool &external_sorter::posts() {
+  return current->posts();
+}
+
+bool external_sorter::add(const stamp &s) {
+  current->add(s);
+  count++;
+
+  // Buckets grow by doubling, so a stamp may take twice its size.
+  current_bytes += 2 * sizeof(stamp) + heap_bytes(s.name) + heap_bytes(s.value_text);
+  const post_pool &pool = current->posts();
+  if (pool.size() != current_posts) {
+    current_posts = pool.size();
+    current_bytes += 2 * pool.name(s.post).size() + 64;
+  }
+
+  if (current_bytes > memory_limit)
+    return spill();
+  return true;
+}
+
+bool external_sorter::spill() {
+  {
+    phase_timer timer(phase_sort);
+    current->sort();
+  }
+
+  phase_timer timer(phase_snapshot);
+  string path = temporary_file(dir, "run");
+  if (path.empty())
+    return false;
+  runs.push_back(path);
+
+  vector<char> buffer(min(max(memory_limit / 4, min_buffer_bytes), max_buffer_bytes));
+  std::ofstream file;
+  file.rdbuf()->pubsetbuf(buffer.data(), buffer.size());
+  file.open(path, std::ios::binary | std::ios::trunc);
+
+  const post_pool &pool = current->posts();
+  current->for_each_in(make_pair(first_year, last_year), [&file, &pool](const stamp &s) {
+    write_record(file, s.year, s.value, pool.name(s.post), s.name, s.value_text);
+  });
+  file.close();
+
+  current.reset(new stamp_index);
+  current_bytes = 0;
+  current_posts = 0;
+
+  if (!file) {
+    cerr << "Cannot write run " << path << endl;
+    return false;
+  }
+  return true;
+}
+
+bool external_sorter::write_catalog(const string &path) {
+  {
+    phase_timer timer(phase_sort);
+    current->sort();
+  }
+
+  phase_timer timer(phase_snapshot);
+  snapshot_writer writer;
+  if (!writer.open(path))
+    return false;
+
+  string line;
+  const post_pool &pool = current->posts();
+  current->for_each_in(make_pair(first_year, last_year),
+                       [&writer, &line, &pool](const stamp &s) {
+                         line.clear();
+                         append_output_line(line, s, pool);
+                         writer.add(s.year, line, pool.name(s.post).size());
+                       });
+  return writer.close();
+}
+
+bool external_sorter::finish(const string &path) {
+  temporary_catalog = path.empty();
+  catalog = temporary_catalog ? temporary_file(dir, "catalog") : path;
+  if (catalog.empty())
+    return false;
+
+  // Everything fits in the memory: no runs are needed.
+  if (runs.empty())
+    return write_catalog(catalog);
+
+  if (current->size() > 0 && !spill())
+    return false;
+
+  phase_timer timer(phase_snapshot);
+  size_t buffer_size = min(max(memory_limit / (merge_fan_in + 1), min_buffer_bytes),
+                           max_buffer_bytes);
+
+  while (runs.size() > merge_fan_in) {
+    vector<string> inputs(runs.begin(), runs.begin() + merge_fan_in);
+    string path = temporary_file(dir, "run");
+    if (path.empty())
+      return false;
+    runs.push_back(path);
+
+    vector<char> buffer(buffer_size);
+    std::ofstream file;
+    file.rdbuf()->pubsetbuf(buffer.data(), buffer.size());
+    file.open(path, std::ios::binary | std::ios::trunc);
+    bool merged = merge_runs(inputs, buffer_size, [&file](const run_record &r) {
+      write_record(file, r.year, r.value, r.post, r.name, r.value_text);
+    });
+    file.close();
+    if (!merged)
+      return false;
+    if (!file) {
+      cerr << "Cannot write run " << path << endl;
+      return false;
+    }
+
+    for (const string &input : inputs)
+      remove(input.c_str());
+    runs.erase(runs.begin(), runs.begin() + merge_fan_in);
+  }
+
+  snapshot_writer writer;
+  if (!writer.open(catalog))
+    return false;
+  string line;
+  bool merged = merge_runs(runs, buffer_size, [&writer, &line](const run_record &r) {
+    line.clear();
+    append_output_line(line, r);
+    writer.add(r.year, line, r.post.size());
+  });
+  return writer.close() && merged;
+}
+
+const string &external_sorter::catalog_path() const {
+  return catalog;
+}
+
+size_t external_sorter::size() const {
+  return count;
+}
+
+bool parse_size(const string &text, size_t &size) {
+  size_t i = 0;
+  size = 0;
+  while (i < text.size() && '0' <= text[i] && text[i] <= '9') {
+    if (size > (SIZE_MAX - 9) / 10)
+      return false;
+    size = 10 * size + (text[i] - '0');
+    i++;
+  }
+  if (i == 0 || size == 0)
+    return false;
+
+  if (i + 1 == text.size()) {
+    const string units = "KMG";
+    size_t unit = units.find(toupper(text[i]));
+    if (unit == string::npos)
+      return false;
+    for (size_t k = 0; k <= unit; ++k) {
+      if (size > SIZE_MAX / 1024)
+        return false;
+      size *= 1024;
+    }
+  } else if (i != text.size()) {
+    return false;
+  }
+  return true;
+}
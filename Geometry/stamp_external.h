@@ -0,0 +1,88 @@
+/**
+ * Michał Kuźba, Bartosz Bruski, Jakub Kuklis
+ *
+ * Sorting of catalogs larger than the memory.
+ *
+ * Stamps are collected in an index until their estimated size exceeds
+ * the memory budget. Then they are sorted and spilled to a temporary
+ * run file. At the end all runs are merged into a snapshot file (see
+ * stamp_snapshot.h), which queries read with snapshot_file.
+ */
+
+#ifndef STAMP_EXTERNAL_H
+#define STAMP_EXTERNAL_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "stamp.h"
+#include "stamp_index.h"
+
+class external_sorter {
+ public:
+  /**
+   * Runs are written to the given directory. The memory limit bounds
+   * the stamps held in memory and the buffers of the merge.
+   */
+  external_sorter(const std::string &dir, size_t memory_limit);
+
+  /**
+   * Removes the runs and the temporary catalog file.
+   */
+  ~external_sorter();
+
+  external_sorter(const external_sorter &) = delete;
+  external_sorter &operator=(const external_sorter &) = delete;
+
+  /**
+   * Pool to parse the next stamp with. It changes after a spill.
+   */
+  post_pool &posts();
+
+  /**
+   * Add the stamp parsed with posts(), spilling a run if the budget
+   * is exceeded. Returns false if the run could not be written.
+   */
+  bool add(const stamp &s);
+
+  /**
+   * Merge all stamps into a snapshot file at the given path, or at
+   * a temporary one removed with the sorter if the path is empty.
+   * Returns false if some file could not be read or written.
+   */
+  bool finish(const std::string &path);
+
+  /**
+   * Path of the snapshot written by finish().
+   */
+  const std::string &catalog_path() const;
+
+  /**
+   * @return number of the stamps added
+   */
+  size_t size() const;
+
+ private:
+  bool spill();
+  bool write_catalog(const std::string &path);
+
+  std::string dir;
+  size_t memory_limit;
+  std::unique_ptr<stamp_index> current;
+  size_t current_bytes;
+  size_t current_posts;
+  size_t count;
+  std::vector<std::string> runs;
+  std::string catalog;
+  bool temporary_catalog;
+};
+
+/**
+ * Parse a size in bytes, optionally followed by K, M or G.
+ * Returns false if the text is not a positive size.
+ */
+bool parse_size(const std::string &text, size_t &size);
+
+#endif /* STAMP_EXTERNAL_H */
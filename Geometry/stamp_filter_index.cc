@@ -0,0 +1,240 @@
+/**
+ * Michał Kuźba, Bartosz Bruski, Jakub Kuklis
+ */
+
+#include <algorithm>
+#include <iterator>
+
+#include "catalog_view.h"
+#include "stamp_filter_index.h"
+
+using std::string;
+using std::vector;
+using std::make_pair;
+using std::lower_bound;
+using std::upper_bound;
+
+namespace {
+
+uint32_t trigram(const string &text, size_t i) {
+  return (uint32_t) (unsigned char) text[i] << 16 |
+         (uint32_t) (unsigned char) text[i + 1] << 8 |
+         (uint32_t) (unsigned char) text[i + 2];
+}
+
+/**
+ * Distinct trigrams of the name, sorted.
+ */
+void name_trigrams(const string &name, vector<uint32_t> &trigrams) {
+  trigrams.clear();
+  for (size_t j = 0; j + 3 <= name.size(); ++j)
+    trigrams.push_back(trigram(name, j));
+  sort(trigrams.begin(), trigrams.end());
+  trigrams.erase(unique(trigrams.begin(), trigrams.end()), trigrams.end());
+}
+
+typedef std::multimap<long double, uint32_t> value_tree;
+
+/**
+ * Candidates for the stamps satisfying a query. The stamps numbered at
+ * building time are either a contiguous range of positions or a range
+ * of one of the position lists. The inserted ones are a range of
+ * numbers, a range of one of the lists or a range of the value tree.
+ */
+struct candidates {
+  const uint32_t *first, *last;
+  uint32_t range_first, range_last;
+  bool sorted;
+
+  const uint32_t *added_first, *added_last;
+  uint32_t added_range_first, added_range_last;
+  value_tree::const_iterator value_first, value_last;
+  size_t added;
+
+  size_t size() const {
+    return (first == nullptr ? range_last - range_first : last - first) + added;
+  }
+};
+
+/**
+ * Candidates from the ascending list of numbers: the positions inside
+ * [from, to) and all numbers from base on.
+ */
+candidates restrict_to(const vector<uint32_t> &list, uint32_t from, uint32_t to,
+                       uint32_t base) {
+  const uint32_t *begin = list.data(), *end = list.data() + list.size();
+  const uint32_t *added = lower_bound(begin, end, base);
+  return {lower_bound(begin, added, from), lower_bound(begin, added, to), 0, 0, true,
+          added, end, 0, 0, value_tree::const_iterator(), value_tree::const_iterator(),
+          (size_t) (end - added)};
+}
+
+}  // namespace
+
+stamp_filter_index::stamp_filter_index(const stamp_index &stamps)
+    : stamps(stamps), pool(stamps.posts()), year_begin(year_slots),
+      year_numbers(year_slots - 1), by_post(pool.size()) {
+  sorted.reserve(stamps.size());
+  for (int year = first_year; year <= last_year; ++year) {
+    year_begin[year - first_year] = sorted.size();
+    stamps.for_each_in(make_pair(year, year),
+                       [this](const stamp &s) { sorted.push_back(&s); });
+  }
+  year_begin[year_slots - 1] = sorted.size();
+  base = sorted.size();
+
+  by_value.resize(sorted.size());
+  vector<uint32_t> trigrams;
+  for (uint32_t i = 0; i < sorted.size(); ++i) {
+    const stamp &s = *sorted[i];
+    by_post[s.post].push_back(i);
+    by_value[i] = i;
+
+    name_trigrams(s.name, trigrams);
+    for (uint32_t t : trigrams)
+      by_trigram[t].push_back(i);
+  }
+
+  stable_sort(by_value.begin(), by_value.end(), [this](uint32_t a, uint32_t b) {
+    return sorted[a]->value < sorted[b]->value;
+  });
+}
+
+void stamp_filter_index::insert(int year, size_t position) {
+  uint32_t number = sorted.size();
+  positions &numbers = year_numbers[year - first_year];
+  if (numbers.empty())
+    for (uint32_t i = year_begin[year - first_year]; i < year_begin[year + 1 - first_year]; ++i)
+      numbers.push_back(i);
+  numbers.insert(numbers.begin() + position, number);
+
+  // The bucket may have been moved by the insertion.
+  sorted.push_back(nullptr);
+  size_t i = 0;
+  stamps.for_each_in(make_pair(year, year), [this, &numbers, &i](const stamp &s) {
+    sorted[numbers[i++]] = &s;
+  });
+
+  const stamp &s = *sorted[number];
+  if (s.post >= by_post.size())
+    by_post.resize(pool.size());
+  by_post[s.post].push_back(number);
+  inserted_by_value.emplace(s.value, number);
+
+  vector<uint32_t> trigrams;
+  name_trigrams(s.name, trigrams);
+  for (uint32_t t : trigrams)
+    by_trigram[t].push_back(number);
+}
+
+vector<const stamp *> stamp_filter_index::find(const stamp_filter &filter) const {
+  vector<const stamp *> result;
+
+  uint32_t from = year_begin[filter.interval.first - first_year];
+  uint32_t to = year_begin[filter.interval.second + 1 - first_year];
+  if (filter.interval.first > filter.interval.second)
+    return result;
+
+  // Numbers of the inserted stamps do not follow the years,
+  // so all of them are candidates.
+  uint32_t count = sorted.size();
+  candidates best = {nullptr, nullptr, from, to, true,
+                     nullptr, nullptr, base, count,
+                     value_tree::const_iterator(), value_tree::const_iterator(),
+                     count - base};
+
+  if (filter.by_post) {
+    post_id post;
+    if (!pool.find(filter.post, post) || post >= by_post.size())
+      return result;
+    candidates c = restrict_to(by_post[post], from, to, base);
+    if (c.size() < best.size())
+      best = c;
+  }
+
+  if (filter.by_name) {
+    for (size_t j = 0; j + 3 <= filter.name.size(); ++j) {
+      auto it = by_trigram.find(trigram(filter.name, j));
+      if (it == by_trigram.end())
+        return result;
+      candidates c = restrict_to(it->second, from, to, base);
+      if (c.size() < best.size())
+        best = c;
+    }
+  }
+
+  if (filter.by_value) {
+    auto value_less = [this](long double value, uint32_t i) {
+      return value < sorted[i]->value;
+    };
+    auto less_value = [this](uint32_t i, long double value) {
+      return sorted[i]->value < value;
+    };
+    const uint32_t *begin = by_value.data(), *end = by_value.data() + by_value.size();
+    candidates c = {lower_bound(begin, end, filter.min_value, less_value),
+                    upper_bound(begin, end, filter.max_value, value_less), 0, 0, false,
+                    nullptr, nullptr, 0, 0,
+                    inserted_by_value.lower_bound(filter.min_value),
+                    inserted_by_value.upper_bound(filter.max_value), 0};
+    c.added = std::distance(c.value_first, c.value_last);
+    if (c.size() == 0)
+      return result;
+    if (c.size() < best.size())
+      best = c;
+  }
+
+  vector<uint32_t> found;
+  if (best.first == nullptr) {
+    for (uint32_t i = best.range_first; i < best.range_last; ++i)
+      if (matches(*sorted[i], filter, pool))
+        found.push_back(i);
+  } else {
+    for (const uint32_t *i = best.first; i < best.last; ++i)
+      if (matches(*sorted[*i], filter, pool))
+        found.push_back(*i);
+    if (!best.sorted)
+      sort(found.begin(), found.end());
+  }
+
+  result.reserve(found.size());
+  for (uint32_t i : found)
+    result.push_back(sorted[i]);
+  if (best.added == 0)
+    return result;
+
+  vector<const stamp *> added;
+  auto check = [this, &filter, &added](uint32_t i) {
+    if (matches(*sorted[i], filter, pool))
+      added.push_back(sorted[i]);
+  };
+  if (best.added_first != nullptr) {
+    for (const uint32_t *i = best.added_first; i < best.added_last; ++i)
+      check(*i);
+  } else if (best.added_range_first < best.added_range_last) {
+    for (uint32_t i = best.added_range_first; i < best.added_range_last; ++i)
+      check(i);
+  } else {
+    for (auto it = best.value_first; it != best.value_last; ++it)
+      check(it->second);
+  }
+
+  // Stamps numbered at building time are in sorted order, so only
+  // the inserted ones are sorted before merging.
+  stamp_less less(pool);
+  sort(added.begin(), added.end(),
+       [&less](const stamp *a, const stamp *b) { return less(*a, *b); });
+  vector<const stamp *> merged;
+  merged.reserve(result.size() + added.size());
+  std::merge(result.begin(), result.end(), added.begin(), added.end(),
+             back_inserter(merged),
+             [&less](const stamp *a, const stamp *b) { return less(*a, *b); });
+  return merged;
+}
+
+size_t stamp_filter_index::size() const {
+  return sorted.size();
+}
+
+const post_pool &stamp_filter_index::posts() const {
+  return pool;
+}
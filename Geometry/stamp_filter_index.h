@@ -0,0 +1,77 @@
+/**
+ * Michał Kuźba, Bartosz Bruski, Jakub Kuklis
+ *
+ * Secondary indexes answering filtered queries.
+ */
+
+#ifndef STAMP_FILTER_INDEX_H
+#define STAMP_FILTER_INDEX_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "stamp.h"
+#include "stamp_index.h"
+
+/**
+ * Stamps of a sorted stamp_index are numbered with their positions in
+ * the sorted order. Next to the year offsets, the positions are indexed
+ * by post (inverted index), by value (positions sorted by value) and by
+ * every trigram of the name. A query scans only the smallest of the
+ * candidate lists its conditions select and checks the rest of the
+ * conditions on each candidate.
+ *
+ * Stamps inserted into the stamp_index afterwards are added with
+ * insert(). They get the next numbers, which are appended to the post
+ * and trigram lists and kept in a tree by value; the numbers of the
+ * year bucket are looked up again, since the bucket may have moved.
+ * An insertion thus costs as much as stamp_index::insert, not a rebuild.
+ */
+class stamp_filter_index {
+ public:
+  explicit stamp_filter_index(const stamp_index &stamps);
+
+  /**
+   * Index the stamp just inserted into the stamp_index at the given
+   * position of the bucket of the given year.
+   */
+  void insert(int year, size_t position);
+
+  /**
+   * @return stamps satisfying the filter, in sorted order
+   */
+  std::vector<const stamp *> find(const stamp_filter &filter) const;
+
+  /**
+   * @return number of the indexed stamps
+   */
+  size_t size() const;
+
+  /**
+   * Pool of the posts of the indexed stamps.
+   */
+  const post_pool &posts() const;
+
+ private:
+  typedef std::vector<uint32_t> positions;
+
+  const stamp_index &stamps;
+  const post_pool &pool;
+  // Stamps by their numbers; the first base of them are numbered
+  // with their positions in the sorted order at building time.
+  std::vector<const stamp *> sorted;
+  uint32_t base;
+  positions year_begin;
+  // Numbers of the stamps of a year in the order of its bucket,
+  // filled on the first insertion into the year.
+  std::vector<positions> year_numbers;
+  std::vector<positions> by_post;
+  positions by_value;
+  std::multimap<long double, uint32_t> inserted_by_value;
+  std::unordered_map<uint32_t, positions> by_trigram;
+};
+
+#endif /* STAMP_FILTER_INDEX_H */
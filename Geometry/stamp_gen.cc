@@ -0,0 +1,166 @@
+/**
+ * Michał Kuźba, Bartosz Bruski, Jakub Kuklis
+ *
+ * Generator of synthetic stamp catalogs.
+ *
+ * Usage: stamp_gen STAMPS QUERIES [SEED]
+ *
+ * Writes STAMPS catalog lines followed by QUERIES range lines. The output
+ * depends only on the arguments. Catalogs mimic the real ones: names of
+ * one to a dozen words, a few hundred posts of which a handful is very
+ * frequent, values with a dot or a comma, years clustered around the
+ * twentieth century, about one percent of malformed lines, and both
+ * narrow and wide ranges (and some reversed ones) as queries.
+ */
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+using std::cout;
+using std::cerr;
+using std::endl;
+
+namespace {
+
+/**
+ * SplitMix64, so the catalogs are the same on every platform.
+ */
+class generator {
+ public:
+  explicit generator(uint64_t seed) : state(seed) {}
+
+  uint64_t next() {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+  }
+
+  /**
+   * Uniform number from [0, n).
+   */
+  uint64_t below(uint64_t n) { return next() % n; }
+
+  /**
+   * Number from [0, n) with small numbers much more frequent.
+   */
+  uint64_t skewed(uint64_t n) { return below(below(n) + 1); }
+
+ private:
+  uint64_t state;
+};
+
+const vector<string> words = {
+    "One", "Two", "Three", "Penny", "Pence", "Cent", "Cents", "Black",
+    "Magenta", "Inverted", "Jenny", "Yellow", "Blue", "Red", "Queen",
+    "King", "Victoria", "Franklin", "Washington", "Mauritius", "Post",
+    "Office", "Skilling", "Grill", "Airmail", "Eagle", "Lion", "Ship",
+    "Train", "Pomidor", "Brzoza", "Buk", "Dynia", "slipper", "Z-Grill",
+    "ONE", "CENT", "CENTS", "Jubilee", "Coronation", "Olympic", "Winter",
+    "Summer", "Flower", "Bird", "Castle", "Bridge", "Mountain", "River"};
+
+const vector<string> post_words = {
+    "Poczta", "Polska", "U.S.POSTAGE", "Mauritius", "SVERIGE", "British",
+    "Guiana", "Kanada", "Deutsche", "Bundespost", "Royal", "Mail",
+    "Helvetia", "Republique", "Francaise", "Magyar", "Posta", "Nippon",
+    "Espana", "Italia", "Danmark", "Norge", "Suomi", "Eesti", "Island"};
+
+/**
+ * Posts are combinations of one to three post words, numbered so that
+ * the frequent ones get small numbers.
+ */
+string post(uint64_t number) {
+  string result = post_words[number % post_words.size()];
+  number /= post_words.size();
+  while (number > 0) {
+    result += " " + post_words[number % post_words.size()];
+    number /= post_words.size();
+  }
+  return result;
+}
+
+string name(generator &gen) {
+  size_t length = 1 + gen.skewed(12);
+  string result;
+  for (size_t i = 0; i < length; ++i) {
+    if (i > 0)
+      result += gen.below(20) == 0 ? "   " : " ";
+    result += words[gen.below(words.size())];
+  }
+  if (gen.below(10) == 0)
+    result += " " + std::to_string(gen.below(1000));
+  return result;
+}
+
+string value(generator &gen) {
+  string result = std::to_string(gen.skewed(100000));
+  switch (gen.below(3)) {
+    case 0:
+      return result;
+    case 1:
+      return result + "," + std::to_string(10 + gen.below(90));
+    default:
+      return result + "." + std::to_string(gen.below(10));
+  }
+}
+
+int year(generator &gen) {
+  // Sum of uniform numbers, centered around 1950.
+  int sum = 0;
+  for (int i = 0; i < 4; ++i)
+    sum += gen.below(101);
+  return 1750 + sum;
+}
+
+string stamp_line(generator &gen) {
+  string line = name(gen) + " " + value(gen) + " " + std::to_string(year(gen)) +
+                " " + post(gen.skewed(300));
+
+  switch (gen.below(400)) {
+    case 0:
+      return name(gen) + " " + std::to_string(year(gen)) + " " + post(gen.below(300));
+    case 1:
+      return name(gen) + " " + value(gen) + " " + std::to_string(3000 + gen.below(7000)) +
+             " " + post(gen.below(300));
+    case 2:
+      return name(gen);
+    case 3:
+      return "  " + line + "  ";
+    default:
+      return line;
+  }
+}
+
+string query_line(generator &gen) {
+  int from = year(gen);
+  int length = gen.below(20) == 0 ? gen.below(100) : gen.below(5);
+  int to = from + length;
+  if (gen.below(100) == 0)
+    std::swap(from, to);
+  return std::to_string(from) + " " + std::to_string(to);
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  if (argc < 3 || argc > 4) {
+    cerr << "Usage: " << argv[0] << " STAMPS QUERIES [SEED]" << endl;
+    return 1;
+  }
+
+  uint64_t stamps = std::stoull(argv[1]);
+  uint64_t queries = std::stoull(argv[2]);
+  generator gen(argc == 4 ? std::stoull(argv[3]) : 1);
+
+  std::ios_base::sync_with_stdio(false);
+  for (uint64_t i = 0; i < stamps; ++i)
+    cout << stamp_line(gen) << '\n';
+  for (uint64_t i = 0; i < queries; ++i)
+    cout << query_line(gen) << '\n';
+
+  return 0;
+}
@@ -0,0 +1,151 @@
+/**
+ * Michał Kuźba, Bartosz Bruski, Jakub Kuklis
+ */
+
+#include <algorithm>
+
+#include "stamp_index.h"
+
+using std::vector;
+
+stamp_index::stamp_index()
+    : years(last_year - first_year + 1), count(0) {}
+
+void stamp_index::add(const stamp &s) {
+  years[s.year - first_year].push_back(s);
+  count++;
+}
+
+size_t stamp_index::insert(const stamp &s) {
+  vector<stamp> &bucket = years[s.year - first_year];
+  auto it = bucket.insert(upper_bound(bucket.begin(), bucket.end(), s, stamp_less(pool)), s);
+  count++;
+  return it - bucket.begin();
+}
+
+void stamp_index::sort() {
+  const vector<uint32_t> &rank = pool.ranks();
+  vector<uint32_t> order, group_begin, next;
+  vector<stamp> sorted;
+
+  // Ties on the post are broken like in stamp_less.
+  auto tie_less = [](const stamp &a, const stamp &b) {
+    if (a.value != b.value)
+      return a.value < b.value;
+    int names = a.name.compare(b.name);
+    if (names != 0)
+      return names < 0;
+    return a.value_text < b.value_text;
+  };
+
+  // Buckets already order the stamps by year. Within a bucket the
+  // indices of the stamps are sorted, and the stamps are moved once.
+  for (vector<stamp> &bucket : years) {
+    if (bucket.size() < 2)
+      continue;
+
+    order.resize(bucket.size());
+    if (rank.size() <= 4 * bucket.size()) {
+      // Counting sort by the rank of the post, then the groups
+      // of the same post are sorted by the rest of the fields.
+      group_begin.assign(rank.size() + 1, 0);
+      for (const stamp &s : bucket)
+        group_begin[rank[s.post] + 1]++;
+      for (size_t r = 0; r < rank.size(); ++r)
+        group_begin[r + 1] += group_begin[r];
+      next = group_begin;
+      for (uint32_t i = 0; i < bucket.size(); ++i)
+        order[next[rank[bucket[i].post]]++] = i;
+
+      for (size_t r = 0; r < rank.size(); ++r) {
+        if (group_begin[r + 1] - group_begin[r] > 1)
+          std::sort(order.begin() + group_begin[r], order.begin() + group_begin[r + 1],
+                    [&bucket, &tie_less](uint32_t a, uint32_t b) {
+                      return tie_less(bucket[a], bucket[b]);
+                    });
+      }
+    } else {
+      for (uint32_t i = 0; i < bucket.size(); ++i)
+        order[i] = i;
+      std::sort(order.begin(), order.end(),
+                [&bucket, &rank, &tie_less](uint32_t a, uint32_t b) {
+                  if (bucket[a].post != bucket[b].post)
+                    return rank[bucket[a].post] < rank[bucket[b].post];
+                  return tie_less(bucket[a], bucket[b]);
+                });
+    }
+
+    sorted.clear();
+    sorted.reserve(bucket.size());
+    for (uint32_t i : order)
+      sorted.push_back(std::move(bucket[i]));
+    bucket.swap(sorted);
+  }
+}
+
+void stamp_index::merge(vector<stamp_index> &sources) {
+  // Posts of every source are interned in this pool first,
+  // so that all stamps compare by the ranks of this pool.
+  for (stamp_index &source : sources) {
+    vector<post_id> ids(source.pool.size());
+    for (post_id id = 0; id < ids.size(); ++id)
+      ids[id] = pool.intern(source.pool.name(id));
+    for (vector<stamp> &bucket : source.years)
+      for (stamp &s : bucket)
+        s.post = ids[s.post];
+    count += source.count;
+    source.count = 0;
+  }
+
+  stamp_less less(pool);
+  vector<std::pair<size_t, size_t>> heads;  // (source, position)
+
+  for (size_t y = 0; y < years.size(); ++y) {
+    vector<stamp> &bucket = years[y];
+    heads.clear();
+    size_t total = 0;
+    for (size_t i = 0; i < sources.size(); ++i) {
+      if (!sources[i].years[y].empty())
+        heads.emplace_back(i, 0);
+      total += sources[i].years[y].size();
+    }
+
+    if (heads.size() == 1) {
+      bucket.swap(sources[heads[0].first].years[y]);
+      continue;
+    }
+
+    bucket.reserve(total);
+    auto head_greater = [&sources, &less, y](const std::pair<size_t, size_t> &a,
+                                             const std::pair<size_t, size_t> &b) {
+      return less(sources[b.first].years[y][b.second],
+                  sources[a.first].years[y][a.second]);
+    };
+    std::make_heap(heads.begin(), heads.end(), head_greater);
+    while (!heads.empty()) {
+      std::pop_heap(heads.begin(), heads.end(), head_greater);
+      std::pair<size_t, size_t> &head = heads.back();
+      vector<stamp> &from = sources[head.first].years[y];
+      bucket.push_back(std::move(from[head.second]));
+      if (++head.second < from.size())
+        std::push_heap(heads.begin(), heads.end(), head_greater);
+      else
+        heads.pop_back();
+    }
+
+    for (stamp_index &source : sources)
+      vector<stamp>().swap(source.years[y]);
+  }
+}
+
+size_t stamp_index::size() const {
+  return count;
+}
+
+post_pool &stamp_index::posts() {
+  return pool;
+}
+
+const post_pool &stamp_index::posts() const {
+  return pool;
+}
@@ -0,0 +1,79 @@
+/**
+ * Michał Kuźba, Bartosz Bruski, Jakub Kuklis
+ *
+ * Index of stamps ordered by their release year.
+ */
+
+#ifndef STAMP_INDEX_H
+#define STAMP_INDEX_H
+
+#include <cstddef>
+#include <vector>
+
+#include "stamp.h"
+
+/**
+ * Stamps are kept in one bucket per correct year. Buckets can be filled
+ * in any order and sorted once with sort(), or kept sorted all the time
+ * with insert(), which only moves the stamps of a single year.
+ * The index owns the pool of the posts of its stamps.
+ */
+class stamp_index {
+ public:
+  stamp_index();
+
+  /**
+   * Append the stamp to its year bucket without keeping the bucket sorted.
+   */
+  void add(const stamp &s);
+
+  /**
+   * Insert the stamp into its already sorted year bucket.
+   * @return position of the stamp in the bucket
+   */
+  size_t insert(const stamp &s);
+
+  /**
+   * Sort every year bucket: by post with a counting sort over the post
+   * ranks, then by the other fields within the groups of equal posts.
+   * Only indices are sorted; every stamp is moved once.
+   */
+  void sort();
+
+  /**
+   * Fill this empty index with the stamps of the sorted sources,
+   * which are left empty. Stamps of every year are k-way merged,
+   * so nothing is sorted again.
+   */
+  void merge(std::vector<stamp_index> &sources);
+
+  /**
+   * @return number of the stamps in the index
+   */
+  size_t size() const;
+
+  /**
+   * Pool to parse the stamps of this index with.
+   */
+  post_pool &posts();
+  const post_pool &posts() const;
+
+  /**
+   * Call f on every stamp from the given time interval, in sorted order.
+   * Years outside of the correct ones have no stamps.
+   */
+  template <typename F>
+  void for_each_in(paII interval, F f) const {
+    interval = clamp_interval(interval);
+    for (int year = interval.first; year <= interval.second; ++year)
+      for (const stamp &s : years[year - first_year])
+        f(s);
+  }
+
+ private:
+  std::vector<std::vector<stamp>> years;
+  size_t count;
+  post_pool pool;
+};
+
+#endif /* STAMP_INDEX_H */
@@ -0,0 +1,254 @@
+/**
+ * Michał Kuźba, Bartosz Bruski, Jakub Kuklis
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "stamp_server.h"
+#include "stamp_stats.h"
+
+using std::string;
+using std::vector;
+using std::cerr;
+using std::endl;
+
+namespace {
+
+/**
+ * A client is not read from while this much of its answers is waiting
+ * to be sent, so a client that does not read cannot exhaust memory.
+ */
+const size_t max_pending_output = 16 << 20;
+
+/**
+ * A client whose unfinished query grows longer than this is closed,
+ * so a client that never ends its line cannot exhaust memory.
+ */
+const size_t max_pending_input = 16 << 20;
+
+const size_t read_size = 64 << 10;
+
+volatile sig_atomic_t stopped = 0;
+
+void stop(int) {
+  stopped = 1;
+}
+
+struct client {
+  int fd;
+  string input;
+  string output;
+  size_t sent;
+  bool closing;
+};
+
+bool set_non_blocking(int fd) {
+  int flags = fcntl(fd, F_GETFL, 0);
+  return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) >= 0;
+}
+
+int listen_on(const string &path) {
+  sockaddr_un address;
+  if (path.size() >= sizeof(address.sun_path)) {
+    cerr << "Socket path too long: " << path << endl;
+    return -1;
+  }
+
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    cerr << "Cannot create socket: " << strerror(errno) << endl;
+    return -1;
+  }
+
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  strcpy(address.sun_path, path.c_str());
+  unlink(path.c_str());
+
+  if (bind(fd, (sockaddr *) &address, sizeof(address)) < 0 ||
+      listen(fd, SOMAXCONN) < 0 || !set_non_blocking(fd)) {
+    cerr << "Cannot listen on " << path << ": " << strerror(errno) << endl;
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+/**
+ * Append the answer to a single query to the output of a client.
+ */
+void answer(const string &line, const catalog_view &catalog,
+            const stamp_filter_index *filters, const stamp_aggregates *aggregates,
+            string &output) {
+  stamp_stats &s = stats();
+  size_t answer_begin = output.size();
+  s.lines++;
+  s.bytes_read += line.size() + 1;
+
+  if (is_range(line)) {
+    paII interval = get_interval(line);
+    output.append(catalog.begin(interval), catalog.length(interval));
+  } else {
+    paBF filtered = filters == nullptr ? paBF() : parse_filter(line);
+    paBA aggregate = aggregates == nullptr || filtered.first ? paBA() : parse_aggregate(line);
+    if (aggregate.first) {
+      output += aggregates->answer(aggregate.second);
+      output += '\n';
+    } else if (!filtered.first) {
+      output += "Error:";
+      output += line;
+      output += "\n\n";
+      s.lines_rejected++;
+      return;
+    } else {
+      vector<const stamp *> found;
+      {
+        phase_timer timer(phase_lookup);
+        found = filters->find(filtered.second);
+      }
+      for (const stamp *p : found) {
+        append_output_line(output, *p, filters->posts());
+        output += '\n';
+      }
+    }
+  }
+
+  s.queries++;
+  if (s.enabled)
+    s.results += std::count(output.begin() + answer_begin, output.end(), '\n');
+  s.bytes_written += output.size() - answer_begin + 1;
+  output += '\n';
+}
+
+/**
+ * Read what the client has sent and answer all complete queries.
+ * Returns false if the client has closed the connection or has sent
+ * too long a line.
+ */
+bool receive(client &c, const catalog_view &catalog,
+             const stamp_filter_index *filters, const stamp_aggregates *aggregates) {
+  char buffer[read_size];
+  ssize_t n = read(c.fd, buffer, sizeof(buffer));
+  if (n < 0)
+    return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+  if (n == 0)
+    return false;
+
+  c.input.append(buffer, n);
+  size_t begin = 0, end;
+  while ((end = c.input.find('\n', begin)) != string::npos) {
+    answer(c.input.substr(begin, end - begin), catalog, filters, aggregates,
+           c.output);
+    begin = end + 1;
+  }
+  c.input.erase(0, begin);
+  if (c.input.size() > max_pending_input) {
+    cerr << "Closing a client with a line longer than " << max_pending_input
+         << " bytes" << endl;
+    string().swap(c.input);
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Send as much of the pending answers as the socket accepts.
+ * Returns false on an error.
+ */
+bool send_pending(client &c) {
+  while (c.sent < c.output.size()) {
+    ssize_t n = send(c.fd, c.output.data() + c.sent, c.output.size() - c.sent,
+                     MSG_NOSIGNAL);
+    if (n < 0)
+      return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+    c.sent += n;
+  }
+  c.output.clear();
+  c.sent = 0;
+  return true;
+}
+
+}  // namespace
+
+bool serve(const string &path, const catalog_view &catalog,
+           const stamp_filter_index *filters, const stamp_aggregates *aggregates) {
+  int listen_fd = listen_on(path);
+  if (listen_fd < 0)
+    return false;
+
+  stopped = 0;
+  signal(SIGINT, stop);
+  signal(SIGTERM, stop);
+
+  vector<client> clients;
+  vector<pollfd> fds;
+
+  while (!stopped) {
+    fds.assign(1, {listen_fd, POLLIN, 0});
+    for (const client &c : clients) {
+      short events = 0;
+      if (!c.closing && c.output.size() - c.sent < max_pending_output)
+        events |= POLLIN;
+      if (c.sent < c.output.size())
+        events |= POLLOUT;
+      fds.push_back({c.fd, events, 0});
+    }
+
+    if (poll(fds.data(), fds.size(), -1) < 0) {
+      if (errno == EINTR)
+        continue;
+      cerr << "poll: " << strerror(errno) << endl;
+      break;
+    }
+
+    for (size_t i = 0; i < clients.size(); ++i) {
+      client &c = clients[i];
+      short revents = fds[i + 1].revents;
+      bool alive = true;
+
+      if (revents & (POLLIN | POLLHUP))
+        c.closing = c.closing || !receive(c, catalog, filters, aggregates);
+      if (revents & POLLERR)
+        alive = false;
+      if (alive && c.sent < c.output.size())
+        alive = send_pending(c);
+      if (c.closing && c.sent == c.output.size())
+        alive = false;
+
+      if (!alive)
+        close(c.fd);
+      c.fd = alive ? c.fd : -1;
+    }
+
+    clients.erase(remove_if(clients.begin(), clients.end(),
+                            [](const client &c) { return c.fd < 0; }),
+                  clients.end());
+
+    if (fds[0].revents & POLLIN) {
+      int fd;
+      while ((fd = accept(listen_fd, nullptr, nullptr)) >= 0) {
+        if (set_non_blocking(fd))
+          clients.push_back({fd, string(), string(), 0, false});
+        else
+          close(fd);
+      }
+    }
+  }
+
+  for (const client &c : clients)
+    close(c.fd);
+  close(listen_fd);
+  unlink(path.c_str());
+  return true;
+}
@@ -0,0 +1,30 @@
+/**
+ * Michał Kuźba, Bartosz Bruski, Jakub Kuklis
+ *
+ * Query server over a local UNIX-domain socket.
+ *
+ * A client sends queries, one per line, in the same form as on the
+ * standard input, and may send many of them without waiting for the
+ * answers. Every answer is the list of output lines ended with an empty
+ * line; an incorrect query is answered with "Error:" and the query.
+ */
+
+#ifndef STAMP_SERVER_H
+#define STAMP_SERVER_H
+
+#include <string>
+
+#include "catalog_view.h"
+#include "stamp_aggregates.h"
+#include "stamp_filter_index.h"
+
+/**
+ * Serve the catalog on the socket at the given path until SIGINT or
+ * SIGTERM. Filtered and aggregate queries are answered only if filters
+ * and aggregates respectively are not null. All clients are handled by
+ * a single event loop. Returns false if the socket could not be set up.
+ */
+bool serve(const std::string &path, const catalog_view &catalog,
+           const stamp_filter_index *filters, const stamp_aggregates *aggregates);
+
+#endif /* STAMP_SERVER_H */
@@ -0,0 +1,362 @@
+/**
+ * Michał Kuźba, Bartosz Bruski, Jakub Kuklis
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "stamp_snapshot.h"
+
+using std::string;
+using std::cerr;
+using std::endl;
+using std::make_pair;
+
+namespace {
+
+/**
+ * The last character is the version of the format.
+ */
+const char snapshot_magic[8] = {'Z', 'N', 'A', 'C', 'Z', 'K', 'I', '2'};
+const size_t version_offset = 7;
+
+/**
+ * Written in the native byte order, used to reject snapshots
+ * made on a machine with a different one.
+ */
+const uint64_t byte_order_mark = 0x0102030405060708ULL;
+
+struct snapshot_header {
+  char magic[8];
+  uint64_t byte_order;
+  uint64_t count;
+  uint64_t text_size;
+  uint64_t offset[year_slots];
+};
+
+const snapshot_header &header_of(const void *data) {
+  return *static_cast<const snapshot_header *>(data);
+}
+
+/**
+ * Report why the snapshot is incorrect: append the message to errors,
+ * or print it if errors is null.
+ */
+bool fail(const string &path, const string &reason, string *errors = nullptr) {
+  string message = "Incorrect snapshot " + path + ": " + reason + "\n";
+  if (errors != nullptr)
+    *errors += message;
+  else
+    cerr << message;
+  return false;
+}
+
+void write_header(std::ostream &file, uint64_t count, uint64_t text_size,
+                  const uint64_t *offset) {
+  snapshot_header header;
+  memcpy(header.magic, snapshot_magic, sizeof(snapshot_magic));
+  header.byte_order = byte_order_mark;
+  header.count = count;
+  header.text_size = text_size;
+  memcpy(header.offset, offset, sizeof(header.offset));
+  file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+}
+
+/**
+ * @return reason why the header is not correct for a file of the
+ * given size, or nullptr if it is
+ */
+const char *check_header(const snapshot_header &header, size_t file_size) {
+  if (memcmp(header.magic, snapshot_magic, version_offset) != 0)
+    return "wrong magic number";
+  if (header.magic[version_offset] != snapshot_magic[version_offset])
+    return "written in another version of the format";
+  if (header.byte_order != byte_order_mark)
+    return "written with a different byte order";
+  if (header.text_size > file_size - sizeof(snapshot_header) ||
+      file_size - sizeof(snapshot_header) - header.text_size !=
+          header.count * sizeof(uint32_t))
+    return "wrong text size";
+  if (header.offset[0] != 0 || header.offset[year_slots - 1] != header.text_size)
+    return "wrong year offsets";
+  for (int i = 1; i < year_slots; ++i)
+    if (header.offset[i] < header.offset[i - 1])
+      return "wrong year offsets";
+  return nullptr;
+}
+
+/**
+ * @return whether the text is a value as the input allows it: digits,
+ * possibly with one separator, a dot or a comma, between them
+ */
+bool is_value(const string &text) {
+  size_t separator = text.find_first_of(".,");
+  if (separator == string::npos)
+    separator = text.size();
+  else if (separator == 0 || separator + 1 == text.size())
+    return false;
+
+  for (size_t i = 0; i < text.size(); ++i)
+    if (i != separator && (text[i] < '0' || text[i] > '9'))
+      return false;
+  return !text.empty();
+}
+
+}  // namespace
+
+bool is_snapshot(const string &path) {
+  char magic[version_offset];
+  std::ifstream file(path, std::ios::binary);
+  return file.read(magic, sizeof(magic)) &&
+         memcmp(magic, snapshot_magic, sizeof(magic)) == 0;
+}
+
+bool write_snapshot(const catalog_text &catalog, const stamp_index &stamps,
+                    const string &path) {
+  std::vector<uint32_t> post_length;
+  post_length.reserve(stamps.size());
+  stamps.for_each_in(make_pair(first_year, last_year),
+                     [&post_length, &stamps](const stamp &s) {
+                       post_length.push_back(stamps.posts().name(s.post).size());
+                     });
+
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  write_header(file, stamps.size(), catalog.text.size(), catalog.offset.data());
+  file.write(catalog.text.data(), catalog.text.size());
+  file.write(reinterpret_cast<const char *>(post_length.data()),
+             post_length.size() * sizeof(uint32_t));
+  file.close();
+
+  if (!file) {
+    cerr << "Cannot write snapshot " << path << endl;
+    return false;
+  }
+  return true;
+}
+
+stamp_snapshot::stamp_snapshot() : data(nullptr), data_size(0) {}
+
+stamp_snapshot::~stamp_snapshot() {
+  if (data != nullptr)
+    munmap(data, data_size);
+}
+
+bool stamp_snapshot::open(const string &path, string *errors) {
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    return fail(path, "cannot open the file", errors);
+
+  struct stat st;
+  if (fstat(fd, &st) < 0 || (size_t) st.st_size < sizeof(snapshot_header)) {
+    close(fd);
+    return fail(path, "file too short", errors);
+  }
+
+  void *mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (mapped == MAP_FAILED)
+    return fail(path, "cannot map the file", errors);
+
+  const char *reason = check_header(header_of(mapped), st.st_size);
+  if (reason != nullptr) {
+    munmap(mapped, st.st_size);
+    return fail(path, reason, errors);
+  }
+
+  if (data != nullptr)
+    munmap(data, data_size);
+  data = mapped;
+  data_size = st.st_size;
+  this->path = path;
+  madvise(data, data_size, MADV_RANDOM);
+  return true;
+}
+
+size_t stamp_snapshot::size() const {
+  return data == nullptr ? 0 : header_of(data).count;
+}
+
+catalog_view stamp_snapshot::view() const {
+  const snapshot_header &header = header_of(data);
+  return {static_cast<const char *>(data) + sizeof(snapshot_header), header.offset};
+}
+
+bool stamp_snapshot::load(stamp_index &stamps, string *errors) const {
+  const snapshot_header &header = header_of(data);
+  const char *text = static_cast<const char *>(data) + sizeof(snapshot_header);
+  const char *post_length = text + header.text_size;
+  post_pool &posts = stamps.posts();
+
+  // Every line is "year post value name"; the value has no spaces,
+  // so the length of the post is enough to split the line.
+  const char *line = text;
+  size_t number = 0;
+  for (int year = first_year; year <= last_year; ++year) {
+    const char *year_end = text + header.offset[year + 1 - first_year];
+    while (line < year_end) {
+      // check_header only matches the sizes; the lines are counted here.
+      if (number == header.count)
+        return fail(path, "more lines than stamps", errors);
+      const char *end = static_cast<const char *>(memchr(line, '\n', year_end - line));
+      uint32_t length;
+      memcpy(&length, post_length + number * sizeof(length), sizeof(length));
+      if (end == nullptr || end - line < 5 + (ptrdiff_t) length + 2)
+        return fail(path, "wrong post lengths", errors);
+
+      const char *post = line + 5;
+      const char *value = post + length + 1;
+      const char *space = static_cast<const char *>(memchr(value, ' ', end - value));
+      if (space == nullptr)
+        return fail(path, "wrong post lengths", errors);
+
+      stamp s;
+      s.year = year;
+      s.post = posts.intern(string(post, length));
+      s.value_text.assign(value, space);
+      s.name.assign(space + 1, end);
+      if (!is_value(s.value_text))
+        return fail(path, "wrong value", errors);
+      string dotted = s.value_text;
+      std::replace(dotted.begin(), dotted.end(), ',', '.');
+      try {
+        s.value = std::stold(dotted);
+      } catch (const std::out_of_range &) {
+        return fail(path, "wrong value", errors);
+      }
+      stamps.add(s);
+
+      line = end + 1;
+      number++;
+    }
+  }
+  if (number != header.count)
+    return fail(path, "fewer lines than stamps", errors);
+  return true;
+}
+
+snapshot_writer::snapshot_writer()
+    : offset(year_slots), filled(0), count(0), text_size(0) {}
+
+snapshot_writer::~snapshot_writer() {
+  if (!posts_path.empty())
+    remove(posts_path.c_str());
+}
+
+bool snapshot_writer::open(const string &path) {
+  this->path = path;
+  posts_path = path + ".posts";
+  file.open(path, std::ios::binary | std::ios::trunc);
+  posts_file.open(posts_path, std::ios::binary | std::ios::trunc);
+  // The header is written again with the offsets when closing.
+  write_header(file, 0, 0, offset.data());
+  if (!file || !posts_file) {
+    cerr << "Cannot write snapshot " << path << endl;
+    return false;
+  }
+  return true;
+}
+
+void snapshot_writer::add(int year, const string &line, uint32_t post_length) {
+  while (filled <= year - first_year)
+    offset[filled++] = text_size;
+  file.write(line.data(), line.size());
+  file.put('\n');
+  posts_file.write(reinterpret_cast<const char *>(&post_length), sizeof(post_length));
+  text_size += line.size() + 1;
+  count++;
+}
+
+bool snapshot_writer::close() {
+  while (filled < year_slots)
+    offset[filled++] = text_size;
+
+  // The post lengths follow the text.
+  posts_file.close();
+  std::ifstream posts(posts_path, std::ios::binary);
+  if (count > 0)
+    file << posts.rdbuf();
+
+  file.seekp(0);
+  write_header(file, count, text_size, offset.data());
+  file.close();
+  if (!file || !posts_file || !posts) {
+    cerr << "Cannot write snapshot " << path << endl;
+    return false;
+  }
+  return true;
+}
+
+snapshot_file::snapshot_file() : fd(-1), offset(year_slots), count(0) {}
+
+snapshot_file::~snapshot_file() {
+  if (fd >= 0)
+    ::close(fd);
+}
+
+bool snapshot_file::open(const string &path) {
+  int file = ::open(path.c_str(), O_RDONLY);
+  if (file < 0)
+    return fail(path, "cannot open the file");
+
+  struct stat st;
+  snapshot_header header;
+  if (fstat(file, &st) < 0 || (size_t) st.st_size < sizeof(snapshot_header) ||
+      pread(file, &header, sizeof(header), 0) != (ssize_t) sizeof(header)) {
+    ::close(file);
+    return fail(path, "file too short");
+  }
+
+  const char *reason = check_header(header, st.st_size);
+  if (reason != nullptr) {
+    ::close(file);
+    return fail(path, reason);
+  }
+
+  if (fd >= 0)
+    ::close(fd);
+  fd = file;
+  count = header.count;
+  memcpy(offset.data(), header.offset, sizeof(header.offset));
+  posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+  return true;
+}
+
+size_t snapshot_file::size() const {
+  return count;
+}
+
+size_t snapshot_file::length(paII interval) const {
+  return catalog_view{nullptr, offset.data()}.length(interval);
+}
+
+bool snapshot_file::write_lines(paII interval, std::ostream &out,
+                                std::vector<char> &buffer, size_t *lines) const {
+  interval = clamp_interval(interval);
+  uint64_t position = sizeof(snapshot_header) + offset[interval.first - first_year];
+  uint64_t left = length(interval);
+
+  while (left > 0) {
+    size_t chunk = std::min<uint64_t>(left, buffer.size());
+    ssize_t got = pread(fd, buffer.data(), chunk, position);
+    if (got <= 0) {
+      cerr << "Cannot read the catalog file" << endl;
+      return false;
+    }
+    out.write(buffer.data(), got);
+    if (lines != nullptr)
+      *lines += std::count(buffer.data(), buffer.data() + got, '\n');
+    position += got;
+    left -= got;
+  }
+  return true;
+}
@@ -0,0 +1,156 @@
+/**
+ * Michał Kuźba, Bartosz Bruski, Jakub Kuklis
+ *
+ * Binary snapshot of the sorted catalog.
+ *
+ * The file starts with a fixed header (magic, byte order mark, number
+ * of stamps, text size and the year offset table) followed by the
+ * output lines of all stamps in sorted order and the length of the post
+ * of every line, which lets the stamps be parsed back. It is mapped into
+ * memory as is, so loading it does not depend on the size of the catalog.
+ */
+
+#ifndef STAMP_SNAPSHOT_H
+#define STAMP_SNAPSHOT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "catalog_view.h"
+#include "stamp_batch.h"
+#include "stamp_index.h"
+
+/**
+ * Check if the file starts like a snapshot, of any version.
+ */
+bool is_snapshot(const std::string &path);
+
+/**
+ * Write the catalog text of the given stamps to the given file.
+ * Returns false if the file could not be written.
+ */
+bool write_snapshot(const catalog_text &catalog, const stamp_index &stamps,
+                    const std::string &path);
+
+/**
+ * Catalog mapped from a snapshot file.
+ */
+class stamp_snapshot {
+ public:
+  stamp_snapshot();
+  ~stamp_snapshot();
+
+  stamp_snapshot(const stamp_snapshot &) = delete;
+  stamp_snapshot &operator=(const stamp_snapshot &) = delete;
+
+  /**
+   * Map the given file. Returns false and reports the reason if the
+   * file is not a correct snapshot: the message is appended to errors,
+   * or printed if errors is null.
+   */
+  bool open(const std::string &path, std::string *errors = nullptr);
+
+  /**
+   * @return number of the stamps in the snapshot
+   */
+  size_t size() const;
+
+  catalog_view view() const;
+
+  /**
+   * Parse the stamps back into the given empty index, in sorted order.
+   * Returns false if the post lengths or their number do not fit the lines;
+   * the reason is reported like in open().
+   */
+  bool load(stamp_index &stamps, std::string *errors = nullptr) const;
+
+ private:
+  void *data;
+  size_t data_size;
+  std::string path;
+};
+
+/**
+ * Snapshot written line by line, for catalogs that are never held
+ * in memory as a whole. Lines have to be added in the sorted order.
+ */
+class snapshot_writer {
+ public:
+  snapshot_writer();
+  ~snapshot_writer();
+
+  /**
+   * Returns false if the file could not be created. The post lengths
+   * are collected in a side file next to it until closing.
+   */
+  bool open(const std::string &path);
+
+  /**
+   * Append the output line (without the newline) of a stamp from
+   * the year, with the length of its post.
+   */
+  void add(int year, const std::string &line, uint32_t post_length);
+
+  /**
+   * Fill in the header. Returns false if the file could not be written.
+   */
+  bool close();
+
+ private:
+  std::ofstream file;
+  std::ofstream posts_file;
+  std::string path;
+  std::string posts_path;
+  std::vector<uint64_t> offset;
+  int filled;
+  uint64_t count;
+  uint64_t text_size;
+};
+
+/**
+ * Snapshot read with pread instead of mapped: only the header is kept
+ * in memory and every query reads just the bytes of its years.
+ */
+class snapshot_file {
+ public:
+  snapshot_file();
+  ~snapshot_file();
+
+  snapshot_file(const snapshot_file &) = delete;
+  snapshot_file &operator=(const snapshot_file &) = delete;
+
+  /**
+   * Open the given file. Returns false and prints the reason
+   * if the file is not a correct snapshot.
+   */
+  bool open(const std::string &path);
+
+  /**
+   * @return number of the stamps in the snapshot
+   */
+  size_t size() const;
+
+  /**
+   * @return number of bytes of the lines from the given time interval
+   */
+  size_t length(paII interval) const;
+
+  /**
+   * Copy the lines from the given time interval to the output, reading
+   * at most buffer.size() bytes at a time. The lines are counted if
+   * lines is not null. Returns false on a read error.
+   */
+  bool write_lines(paII interval, std::ostream &out, std::vector<char> &buffer,
+                   size_t *lines = nullptr) const;
+
+ private:
+  int fd;
+  std::vector<uint64_t> offset;
+  uint64_t count;
+};
+
+#endif /* STAMP_SNAPSHOT_H */
@@ -0,0 +1,67 @@
+/**
+ * Michał Kuźba, Bartosz Bruski, Jakub Kuklis
+ */
+
+#include <ctime>
+
+#include <sys/resource.h>
+
+#include "stamp_stats.h"
+
+namespace {
+
+const char *phase_names[phase_count] = {
+    "parse", "sort", "index", "lookup", "output", "snapshot"};
+
+double cpu_seconds() {
+  timespec ts;
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+}  // namespace
+
+stamp_stats &stats() {
+  static stamp_stats current;
+  return current;
+}
+
+void stamp_stats::write(std::ostream &out) const {
+  rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+
+  out << "{\"phases\":{";
+  for (int p = 0; p < phase_count; ++p) {
+    out << (p > 0 ? "," : "") << "\"" << phase_names[p] << "\":{\"wall_s\":"
+        << wall[p] << ",\"cpu_s\":" << cpu[p] << "}";
+  }
+  out << "},\"lines_accepted\":" << lines - lines_rejected
+      << ",\"lines_rejected\":" << lines_rejected
+      << ",\"bytes_read\":" << bytes_read
+      << ",\"bytes_written\":" << bytes_written
+      << ",\"queries\":" << queries
+      << ",\"results\":" << results
+      << ",\"peak_rss_kb\":" << usage.ru_maxrss << "}" << std::endl;
+}
+
+phase_timer::phase_timer(stamp_phase phase)
+    : phase(phase), running(stats().enabled), cpu_start(0) {
+  if (running) {
+    wall_start = std::chrono::steady_clock::now();
+    cpu_start = cpu_seconds();
+  }
+}
+
+phase_timer::~phase_timer() {
+  stop();
+}
+
+void phase_timer::stop() {
+  if (running) {
+    stamp_stats &s = stats();
+    s.wall[phase] += std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - wall_start).count();
+    s.cpu[phase] += cpu_seconds() - cpu_start;
+    running = false;
+  }
+}
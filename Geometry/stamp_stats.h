@@ -0,0 +1,76 @@
+/**
+ * Michał Kuźba, Bartosz Bruski, Jakub Kuklis
+ *
+ * Optional statistics of a run of the stamp program.
+ */
+
+#ifndef STAMP_STATS_H
+#define STAMP_STATS_H
+
+#include <chrono>
+#include <cstddef>
+#include <ostream>
+
+enum stamp_phase {
+  phase_parse,     // recognising and parsing input lines
+  phase_sort,      // sorting the catalog
+  phase_index,     // building the catalog text and secondary indexes
+  phase_lookup,    // finding the stamps of filtered queries
+  phase_output,    // formatting and writing answers
+  phase_snapshot,  // writing or mapping a snapshot
+  phase_count
+};
+
+/**
+ * Counters and per-phase times. Nothing is measured unless enabled,
+ * so the program is not slowed down by default.
+ */
+struct stamp_stats {
+  bool enabled = false;
+
+  double wall[phase_count] = {};
+  double cpu[phase_count] = {};
+
+  size_t lines = 0;
+  size_t lines_rejected = 0;
+  size_t bytes_read = 0;
+  size_t bytes_written = 0;
+  size_t queries = 0;
+  size_t results = 0;
+
+  /**
+   * Write the statistics as a single JSON object.
+   */
+  void write(std::ostream &out) const;
+};
+
+/**
+ * Statistics of the current run.
+ */
+stamp_stats &stats();
+
+/**
+ * Adds the wall and CPU time from its creation to its destruction
+ * to the given phase, if the statistics are enabled.
+ */
+class phase_timer {
+ public:
+  explicit phase_timer(stamp_phase phase);
+  ~phase_timer();
+
+  /**
+   * End the measurement before the destruction.
+   */
+  void stop();
+
+  phase_timer(const phase_timer &) = delete;
+  phase_timer &operator=(const phase_timer &) = delete;
+
+ private:
+  stamp_phase phase;
+  bool running;
+  std::chrono::steady_clock::time_point wall_start;
+  double cpu_start;
+};
+
+#endif /* STAMP_STATS_H */
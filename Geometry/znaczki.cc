@@ -4,231 +4,636 @@
  * Our assumption is that correct years are in (1000,2999) range.
  * We consider "Stamp 1000 1000 1000" to be a correct stamp,
  * with value=1000, year=1000 and post="1000".
+ *
+ * Usage: znaczki [--incremental | --batch] [--dump-snapshot FILE]
+ *                [--serve SOCKET]
+ *        znaczki [--batch] --snapshot FILE [--serve SOCKET]
+ *        znaczki [--batch] --memory-limit SIZE [--spill-dir DIR]
+ *                [--dump-snapshot FILE] [--serve SOCKET]
+ *        znaczki [--incremental | --batch] --catalog FILE [--catalog FILE]...
+ *                [--dump-snapshot FILE] [--serve SOCKET]
+ *        znaczki [--batch] --compact [--catalog FILE]...
+ *
+ * By default all stamps are read first and the first range starts
+ * the queries, after which stamp lines are errors. In the incremental
+ * mode stamp and range lines can be interleaved freely. In the batch
+ * mode all queries are read before any of them is answered.
+ *
+ * Apart from the batch mode, a range can be followed by conditions
+ * narrowing the query, e.g. "1900 2000 | post Mauritius | value 1 2,5
+ * | name Penny" (see parse_filter). Aggregates of a range are queried
+ * with "count", "sum", "max" or "posts" followed by the range, e.g.
+ * "posts 1900 2000" prints the number of distinct posts.
+ *
+ * --dump-snapshot writes the sorted catalog to a binary file at the end
+ * of the input. --snapshot starts from such a file instead of reading
+ * stamps, so every input line is a query.
+ *
+ * --memory-limit sorts the catalog out of core (see stamp_external.h):
+ * stamps beyond SIZE bytes (with an optional K, M or G suffix) are
+ * spilled in sorted runs to temporary files in the --spill-dir directory
+ * ($TMPDIR or /tmp by default) and merged into a snapshot file. Queries
+ * read only the bytes of their years from that file; as with --snapshot,
+ * only plain ranges are queries. The file is kept if --dump-snapshot
+ * names it.
+ *
+ * --catalog loads the stamps from the given files instead of the input
+ * (see stamp_catalogs.h). Each file holds stamp lines or a snapshot; the
+ * files are loaded in parallel and their sorted stamps merged. Then the
+ * input holds only queries, and in the incremental mode also stamps.
+ *
+ * --compact keeps the sorted catalog compressed in memory (see
+ * stamp_compact.h) once the queries start, and decodes only the stamps
+ * of the queried years. Only plain ranges are queries then.
+ *
+ * --serve answers queries over a UNIX-domain socket (see stamp_server.h)
+ * once the catalog is loaded: after the end of the input, or right away
+ * when it comes from a snapshot.
+ *
+ * --stats writes the time of every phase and the counters of the run
+ * (see stamp_stats.h) as JSON to the standard error at the exit,
+ * --stats-file FILE writes them to the file instead.
  */
 
-#include <iostream>
-#include <regex>
-#include <tuple>
-#include <vector>
 #include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
 #include <utility>
+#include <vector>
+
+#include "stamp.h"
+#include "stamp_aggregates.h"
+#include "stamp_batch.h"
+#include "stamp_catalogs.h"
+#include "stamp_compact.h"
+#include "stamp_external.h"
+#include "stamp_filter_index.h"
+#include "stamp_index.h"
+#include "stamp_server.h"
+#include "stamp_snapshot.h"
+#include "stamp_stats.h"
 
 // using namespace std;
 
 using std::string;
-using std::pair;
-using std::make_pair;
-using std::tuple;
-using std::make_tuple;
-using std::get;
-using std::regex;
-using std::regex_match;
-using std::regex_search;
-using std::regex_replace;
-using std::smatch;
 using std::cout;
 using std::cerr;
 using std::cin;
 using std::endl;
 using std::getline;
+using std::make_pair;
 using std::vector;
+using std::unique_ptr;
 
 /**
- * Stamp is represented as a tuple of
- * (year, post, value, name, parsed information for printing).
+ * Options given in the command line.
  */
-typedef tuple<int, string, long double, string, string> stamp;
-
-typedef pair<int, int> paII;
-typedef pair<bool, stamp> paBT;
+struct options {
+  bool incremental = false;
+  bool batch = false;
+  string dump_snapshot;
+  string snapshot;
+  string serve;
+  bool stats = false;
+  string stats_file;
+  size_t memory_limit = 0;
+  string spill_dir;
+  vector<string> catalogs;
+  bool compact = false;
+};
+
+const char usage[] =
+    " [--incremental | --batch] [--dump-snapshot FILE] [--serve SOCKET]\n"
+    "       [--batch] --snapshot FILE [--serve SOCKET]\n"
+    "       [--batch] --memory-limit SIZE [--spill-dir DIR] [--dump-snapshot FILE]\n"
+    "       [--serve SOCKET]\n"
+    "       [--incremental | --batch] --catalog FILE [--catalog FILE]...\n"
+    "       [--dump-snapshot FILE] [--serve SOCKET]\n"
+    "       [--batch] --compact [--catalog FILE]...\n"
+    "       [--stats | --stats-file FILE]";
 
 /**
- * Constant variables used in function parse()
- * to denote an incorrect line.
+ * Find all stamps from the given time interval.
  */
-const stamp error_stamp = make_tuple(0, "", 0, "", "");
-const paBT error_pair = make_pair(false, error_stamp);
+void query(const stamp_index &stamps, paII interval) {
+  phase_timer timer(phase_output);
+  stamp_stats &s = stats();
+  string line;
+  stamps.for_each_in(interval, [&line, &stamps, &s](const stamp &p) {
+    line.clear();
+    append_output_line(line, p, stamps.posts());
+    cout << line << endl;
+    s.results++;
+    s.bytes_written += line.size() + 1;
+  });
+}
 
 /**
- * Replace multiple space with one.
+ * Find all stamps from the given time interval in the mapped catalog.
  */
-string clear_empty_space(string text) {
-  regex re("\\s+");
-  return regex_replace(text, re, " ");
+void query(const catalog_view &catalog, paII interval) {
+  phase_timer timer(phase_output);
+  const char *begin = catalog.begin(interval);
+  size_t length = catalog.length(interval);
+  cout.write(begin, length);
+  cout.flush();
+  if (stats().enabled) {
+    stats().results += std::count(begin, begin + length, '\n');
+    stats().bytes_written += length;
+  }
 }
 
 /**
- * Check if the given string contains a correct range of years.
+ * Find all stamps from the given time interval in the catalog file,
+ * reading only the bytes of the interval.
  */
-bool is_range(string line) {
-  regex re("(\\s*)([0-9]{4})(\\s+)([0-9]{4})(\\s*)");
-
-  smatch m;
+bool query(const snapshot_file &catalog, paII interval, vector<char> &buffer) {
+  phase_timer timer(phase_output);
+  size_t *results = stats().enabled ? &stats().results : nullptr;
+  if (!catalog.write_lines(interval, cout, buffer, results))
+    return false;
+  cout.flush();
+  stats().bytes_written += catalog.length(interval);
+  return true;
+}
 
-  bool match = regex_match(line, m, re);
+/**
+ * Find all stamps from the given time interval in the compressed catalog.
+ */
+void query(const compact_catalog &catalog, paII interval) {
+  phase_timer timer(phase_output);
+  size_t lines = 0;
+  stats().bytes_written += catalog.write_lines(interval, cout, lines);
+  cout.flush();
+  stats().results += lines;
+}
 
-  if (!match) {
-    return false;
+/**
+ * Find all stamps satisfying the filter. The secondary indexes are
+ * built on the first filtered query; stamps inserted later are added
+ * to them one by one.
+ */
+void query(const stamp_index &stamps, unique_ptr<stamp_filter_index> &filters,
+           const stamp_filter &filter) {
+  if (!filters) {
+    phase_timer timer(phase_index);
+    filters.reset(new stamp_filter_index(stamps));
   }
 
-  int left, right;
+  vector<const stamp *> found;
+  {
+    phase_timer timer(phase_lookup);
+    found = filters->find(filter);
+  }
 
-  left = stoi(m[2]);
-  right = stoi(m[4]);
+  phase_timer timer(phase_output);
+  string line;
+  for (const stamp *p : found) {
+    line.clear();
+    append_output_line(line, *p, stamps.posts());
+    cout << line << endl;
+    stats().bytes_written += line.size() + 1;
+  }
+  stats().results += found.size();
+}
 
-  if (left > right)
-    return false;
+/**
+ * Print the aggregate of the stamps from the given time interval.
+ * The tables are built on the first aggregate query and rebuilt when
+ * stamps were added.
+ */
+void query(const stamp_index &stamps, unique_ptr<stamp_aggregates> &aggregates,
+           const aggregate_query &aggregate) {
+  if (!aggregates || aggregates->size() != stamps.size()) {
+    phase_timer timer(phase_index);
+    aggregates.reset(new stamp_aggregates(stamps));
+  }
 
-  return true;
+  phase_timer timer(phase_output);
+  string line = aggregates->answer(aggregate);
+  cout << line << endl;
+  stats().results++;
+  stats().bytes_written += line.size() + 1;
 }
 
-bool is_year(int year_cand) {
-  return (1000 <= year_cand && year_cand < 3000);
+void report_error(int line_number, const string &line) {
+  cerr << "Error in line " << line_number << ":" << line << endl;
+  stats().lines_rejected++;
 }
 
 /**
- * Parse a line with information about stamps.
- * Returns a pair - (correctnes of the input, stamp).
+ * Read a line of the input, counting it in the statistics.
  */
-paBT parse(string line) {
-  bool found = false;
-  string name, value, year, post;
-  int year_num;
-  long double value_num;
-
-  // Regexes to match consecutively: release year, prefix ending
-  // before the year and suffix starting after the year.
-  smatch year_sm;
-  regex year_re("(\\s+)([0-9]{4})");
-
-  smatch pref_sm;
-  regex pref_re("(\\s*)(.+?)(\\s+)([0-9]+[.,][0-9]+|[0-9]+)");
+bool read_line(string &line) {
+  if (!getline(cin, line))
+    return false;
+  stats().lines++;
+  stats().bytes_read += line.size() + 1;
+  return true;
+}
 
-  smatch suff_sm;
-  regex suff_re("(\\s+)(.+\\S)(\\s*)");
+/**
+ * Primary function. Contains program's essential logic.
+ * Leaves all read stamps sorted in the index. If the catalog was loaded
+ * from files, the index is already sorted and the input starts with
+ * queries.
+ * Returns false if the snapshot could not be written.
+ */
+bool process_input(const options &opts, stamp_index &stamps) {
+  int line_number = 1;
+  bool queries_mode = !opts.catalogs.empty();
 
-  string str = line;
+  unique_ptr<stamp_filter_index> filters;
+  unique_ptr<stamp_aggregates> aggregates;
+  vector<paII> queries;
 
-  while (regex_search(str, year_sm, year_re)) {
+  string line;
 
-    int year_cand = stoi(year_sm[0]);
-    bool correct_year = is_year(year_cand);
+  while (read_line(line)) {
+    bool range;
+    paBF filtered = make_pair(false, stamp_filter());
+    paBA aggregate = make_pair(false, aggregate_query());
+    {
+      phase_timer timer(phase_parse);
+      range = is_range(line);
+      if (!range && !opts.batch)
+        filtered = parse_filter(line);
+      if (!range && !filtered.first && !opts.batch)
+        aggregate = parse_aggregate(line);
+    }
+    bool is_query = range || filtered.first || aggregate.first;
 
-    // Prefix of line that ends before the year candidate
-    int curr_pref_length = year_sm.prefix().str().size();
-    string pref = line.substr(0, line.size() - str.size() + curr_pref_length);
-    bool correct_pref = regex_match(pref, pref_sm, pref_re);
+    if (queries_mode == false && is_query) {
+      // Stamps are sorted once - before answering queries.
+      // In the incremental mode they are kept sorted from the start.
+      if (!opts.incremental) {
+        phase_timer timer(phase_sort);
+        stamps.sort();
+      }
+      queries_mode = true;
+    }
 
-    string suff = year_sm.suffix().str();
-    bool correct_suff = regex_match(suff, suff_sm, suff_re);
+    if (is_query)
+      stats().queries++;
 
-    if (correct_year && correct_pref && correct_suff) {
-      found = true;
-      name = clear_empty_space(pref_sm[2]);
-      value = pref_sm[4];
-      year = year_sm[2];
-      post = clear_empty_space(suff_sm[2]);
-      year_num = year_cand;
+    if (range) {
+      paII interval = get_interval(line);
+      if (opts.batch)
+        queries.push_back(interval);
+      else
+        query(stamps, interval);
+    } else if (filtered.first) {
+      query(stamps, filters, filtered.second);
+    } else if (aggregate.first) {
+      query(stamps, aggregates, aggregate.second);
+    } else if (!queries_mode || opts.incremental) {
+      paBT parsed;
+      {
+        phase_timer timer(phase_parse);
+        parsed = parse(line, stamps.posts());
+      }
+      if (parsed.first == false) {
+        report_error(line_number, line);
+      } else if (opts.incremental) {
+        size_t position = stamps.insert(parsed.second);
+        if (filters) {
+          phase_timer timer(phase_index);
+          filters->insert(parsed.second.year, position);
+        }
+      } else {
+        stamps.add(parsed.second);
+      }
+    } else {
+      report_error(line_number, line);
     }
 
-    str = year_sm.suffix().str();
+    line_number++;
   }
 
-  if (found) {
-    string parsed_info = year + " " + post + " " + value + " " + name;
-
-    // Normalization of notation
-    regex comma_dot(",");
-    value = regex_replace(value, comma_dot, ".");
-
-    value_num = stold(value);
+  if (!queries_mode && !opts.incremental) {
+    phase_timer timer(phase_sort);
+    stamps.sort();
+  }
 
-    stamp res = make_tuple(year_num, post, value_num, name, parsed_info);
+  if (opts.batch)
+    answer_batch(stamps, queries, cout);
 
-    return make_pair(true, res);
+  if (!opts.dump_snapshot.empty()) {
+    catalog_text catalog;
+    {
+      phase_timer timer(phase_index);
+      catalog = make_catalog_text(stamps);
+    }
+    phase_timer timer(phase_snapshot);
+    return write_snapshot(catalog, stamps, opts.dump_snapshot);
   }
-  return error_pair;
+  return true;
 }
 
 /**
- * Returns the year interval. Function assumes the line includes a correct
- * range.
+ * Answer the queries from the input using the catalog from a snapshot.
  */
-paII get_interval(string line) {
-  smatch year;
+void process_snapshot_queries(const stamp_snapshot &snapshot,
+                              const options &opts) {
+  int line_number = 1;
+  vector<paII> queries;
+  string line;
 
-  regex re("[0-9]{4}");
+  while (read_line(line)) {
+    bool range;
+    {
+      phase_timer timer(phase_parse);
+      range = is_range(line);
+    }
 
-  regex_search(line, year, re);
-  int from = stoi(year[0]);
+    if (!range) {
+      report_error(line_number, line);
+      line_number++;
+      continue;
+    }
 
-  string rest = year.suffix().str();
+    stats().queries++;
+    if (opts.batch)
+      queries.push_back(get_interval(line));
+    else
+      query(snapshot.view(), get_interval(line));
 
-  regex_search(rest, year, re);
-  int to = stoi(year[0]);
+    line_number++;
+  }
 
-  return make_pair(from, to);
+  if (opts.batch)
+    answer_batch(snapshot.view(), queries, cout);
 }
 
 /**
- * Find all stamps from the given time interval.
+ * Process the input with the catalog sorted out of core, within
+ * the memory limit. Only ranges are queries; they are answered from
+ * the merged catalog file.
+ * Returns false if some file could not be read or written.
  */
-void query(vector<stamp> &stamps, paII interval) {
+bool process_external(const options &opts) {
+  int line_number = 1;
+  external_sorter sorter(opts.spill_dir, opts.memory_limit);
+  snapshot_file catalog;
+  bool queries_mode = false;
+  vector<char> buffer(std::min<size_t>(opts.memory_limit, 1 << 20));
+  vector<paII> queries;
+  string line;
 
-  stamp from = make_tuple(interval.first, "", 0., "", "");
+  // Merge the runs and open the result.
+  auto finish = [&sorter, &catalog, &opts]() {
+    if (!sorter.finish(opts.dump_snapshot))
+      return false;
+    phase_timer timer(phase_snapshot);
+    return catalog.open(sorter.catalog_path());
+  };
+
+  while (read_line(line)) {
+    bool range;
+    {
+      phase_timer timer(phase_parse);
+      range = is_range(line);
+    }
+
+    if (range) {
+      if (!queries_mode && !finish())
+        return false;
+      queries_mode = true;
+      stats().queries++;
+      if (opts.batch)
+        queries.push_back(get_interval(line));
+      else if (!query(catalog, get_interval(line), buffer))
+        return false;
+    } else if (!queries_mode) {
+      paBT parsed;
+      {
+        phase_timer timer(phase_parse);
+        parsed = parse(line, sorter.posts());
+      }
+      if (parsed.first == false)
+        report_error(line_number, line);
+      else if (!sorter.add(parsed.second))
+        return false;
+    } else {
+      report_error(line_number, line);
+    }
+
+    line_number++;
+  }
 
-  // First stamp out of the range, 'to', has year set
-  // to first year following the end of interval.
-  stamp to = make_tuple(interval.second + 1, "", 0., "", "");
+  if (!queries_mode && !finish())
+    return false;
 
-  auto it_from = lower_bound(stamps.begin(), stamps.end(), from);
-  auto it_to = lower_bound(stamps.begin(), stamps.end(), to);
+  for (paII interval : queries)
+    if (!query(catalog, interval, buffer))
+      return false;
 
-  // Tuple's 4th index contains the whole name of the stamp.
-  for_each(it_from, it_to, [](stamp &p) { cout << get<4>(p) << endl; });
+  if (!opts.serve.empty()) {
+    stamp_snapshot snapshot;
+    if (!snapshot.open(sorter.catalog_path()))
+      return false;
+    return serve(opts.serve, snapshot.view(), nullptr, nullptr);
+  }
+  return true;
 }
 
 /**
- * Primary function. Contains program's essential logic.
+ * Process the input with the catalog compressed in memory. Stamps are
+ * collected in the index as usual and compressed before the first query,
+ * after which the index is freed. Only ranges are queries.
  */
-void process_input() {
+void process_compact(const options &opts, stamp_index &stamps) {
   int line_number = 1;
-  bool queries_mode = false;
-
-  vector<stamp> stamps;
-
+  unique_ptr<compact_catalog> catalog;
+  vector<paII> queries;
   string line;
 
-  while (getline(cin, line)) {
-
-    if (queries_mode == false && is_range(line)) {
-      // Stamps are sorted once - before answering queries.
-      sort(stamps.begin(), stamps.end());
-      queries_mode = true;
+  auto compact = [&opts, &stamps, &catalog]() {
+    if (opts.catalogs.empty()) {
+      phase_timer timer(phase_sort);
+      stamps.sort();
+    }
+    phase_timer timer(phase_index);
+    catalog.reset(new compact_catalog(stamps));
+    stamps = stamp_index();
+  };
+
+  if (!opts.catalogs.empty())
+    compact();
+
+  while (read_line(line)) {
+    bool range;
+    {
+      phase_timer timer(phase_parse);
+      range = is_range(line);
     }
 
-    if (!queries_mode) {
-      if (parse(line).first == false) {
-        cerr << "Error in line " << line_number << ":" << line << endl;
-      } else {
-        stamps.push_back(parse(line).second);
+    if (range) {
+      if (!catalog)
+        compact();
+      stats().queries++;
+      if (opts.batch)
+        queries.push_back(get_interval(line));
+      else
+        query(*catalog, get_interval(line));
+    } else if (!catalog) {
+      paBT parsed;
+      {
+        phase_timer timer(phase_parse);
+        parsed = parse(line, stamps.posts());
       }
+      if (parsed.first == false)
+        report_error(line_number, line);
+      else
+        stamps.add(parsed.second);
     } else {
-      if (is_range(line)) {
-        paII interval = get_interval(line);
-        query(stamps, interval);
-      } else {
-        cerr << "Error in line " << line_number << ":" << line << endl;
-      }
+      report_error(line_number, line);
     }
 
     line_number++;
   }
+
+  if (!catalog)
+    compact();
+  for (paII interval : queries)
+    query(*catalog, interval);
 }
 
-int main() {
+/**
+ * Fill the options from the command line arguments.
+ * Returns false if some argument is not recognised.
+ */
+bool read_options(int argc, char *argv[], options &opts) {
+  for (int i = 1; i < argc; ++i) {
+    string arg = argv[i];
+    if (arg == "--incremental") {
+      opts.incremental = true;
+    } else if (arg == "--batch") {
+      opts.batch = true;
+    } else if (arg == "--dump-snapshot" && i + 1 < argc) {
+      opts.dump_snapshot = argv[++i];
+    } else if (arg == "--snapshot" && i + 1 < argc) {
+      opts.snapshot = argv[++i];
+    } else if (arg == "--serve" && i + 1 < argc) {
+      opts.serve = argv[++i];
+    } else if (arg == "--stats") {
+      opts.stats = true;
+    } else if (arg == "--stats-file" && i + 1 < argc) {
+      opts.stats = true;
+      opts.stats_file = argv[++i];
+    } else if (arg == "--memory-limit" && i + 1 < argc) {
+      if (!parse_size(argv[++i], opts.memory_limit)) {
+        cerr << "Incorrect memory limit: " << argv[i] << endl;
+        return false;
+      }
+    } else if (arg == "--spill-dir" && i + 1 < argc) {
+      opts.spill_dir = argv[++i];
+    } else if (arg == "--compact") {
+      opts.compact = true;
+    } else if (arg == "--catalog" && i + 1 < argc) {
+      opts.catalogs.push_back(argv[++i]);
+    } else {
+      cerr << "Unknown option: " << arg << endl;
+      return false;
+    }
+  }
+  if (opts.incremental && opts.batch) {
+    cerr << "Options --incremental and --batch exclude each other" << endl;
+    return false;
+  }
+  if (!opts.snapshot.empty() && (opts.incremental || !opts.dump_snapshot.empty())) {
+    cerr << "Option --snapshot excludes --incremental and --dump-snapshot" << endl;
+    return false;
+  }
+  if (opts.memory_limit > 0 && (opts.incremental || !opts.snapshot.empty())) {
+    cerr << "Option --memory-limit excludes --incremental and --snapshot" << endl;
+    return false;
+  }
+  if (!opts.catalogs.empty() && (!opts.snapshot.empty() || opts.memory_limit > 0)) {
+    cerr << "Option --catalog excludes --snapshot and --memory-limit" << endl;
+    return false;
+  }
+  if (opts.compact && (opts.incremental || !opts.snapshot.empty() ||
+                       opts.memory_limit > 0 || !opts.dump_snapshot.empty() ||
+                       !opts.serve.empty())) {
+    cerr << "Option --compact excludes --incremental, --snapshot, --memory-limit,"
+         << " --dump-snapshot and --serve" << endl;
+    return false;
+  }
+  if (opts.spill_dir.empty()) {
+    const char *tmpdir = getenv("TMPDIR");
+    opts.spill_dir = tmpdir != nullptr && *tmpdir != '\0' ? tmpdir : "/tmp";
+  }
+  return true;
+}
 
-  process_input();
+/**
+ * Load the catalog and answer the queries as the options say.
+ * Returns the exit status of the program.
+ */
+int run(const options &opts) {
+  if (!opts.snapshot.empty()) {
+    stamp_snapshot snapshot;
+    {
+      phase_timer timer(phase_snapshot);
+      if (!snapshot.open(opts.snapshot))
+        return 1;
+    }
+    if (opts.serve.empty())
+      process_snapshot_queries(snapshot, opts);
+    else if (!serve(opts.serve, snapshot.view(), nullptr, nullptr))
+      return 1;
+  } else if (opts.memory_limit > 0) {
+    if (!process_external(opts))
+      return 1;
+  } else {
+    stamp_index stamps;
+    if (!opts.catalogs.empty() && !load_catalogs(opts.catalogs, stamps))
+      return 1;
+    if (opts.compact) {
+      process_compact(opts, stamps);
+      return 0;
+    }
+    if (!process_input(opts, stamps))
+      return 1;
+    if (!opts.serve.empty()) {
+      phase_timer timer(phase_index);
+      catalog_text catalog = make_catalog_text(stamps);
+      stamp_filter_index filters(stamps);
+      stamp_aggregates aggregates(stamps);
+      timer.stop();
+      if (!serve(opts.serve, catalog.view(), &filters, &aggregates))
+        return 1;
+    }
+  }
 
   return 0;
 }
+
+int main(int argc, char *argv[]) {
+  options opts;
+
+  if (!read_options(argc, argv, opts)) {
+    cerr << "Usage: " << argv[0] << usage << endl;
+    return 1;
+  }
+
+  stats().enabled = opts.stats;
+  int status = run(opts);
+
+  if (opts.stats_file.empty()) {
+    if (opts.stats)
+      stats().write(cerr);
+  } else {
+    std::ofstream file(opts.stats_file);
+    stats().write(file);
+    if (!file) {
+      cerr << "Cannot write statistics to " << opts.stats_file << endl;
+      status = 1;
+    }
+  }
+
+  return status;
+}
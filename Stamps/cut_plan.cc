@@ -0,0 +1,83 @@
+#include <cassert>
+#include "cut_plan.h"
+
+const unsigned int CutPlan::no_children;
+
+CutPlan::CutPlan(const Rectangle& rec) : leaves(1) {
+    this->nodes.push_back({rec, no_children});
+}
+
+std::pair<unsigned int, unsigned int> CutPlan::cut(unsigned int node, const std::pair<Rectangle, Rectangle>& parts) {
+    unsigned int children;
+    if (this->free_pairs.empty()) {
+        children = (unsigned int) this->nodes.size();
+        this->nodes.push_back({parts.first, no_children});
+        this->nodes.push_back({parts.second, no_children});
+    } else {
+        children = this->free_pairs.back();
+        this->free_pairs.pop_back();
+        this->nodes[children] = {parts.first, no_children};
+        this->nodes[children + 1] = {parts.second, no_children};
+    }
+
+    this->nodes[node].children = children;
+    this->leaves++;
+    return std::make_pair(children, children + 1);
+}
+
+std::pair<unsigned int, unsigned int> CutPlan::cut_vertically(unsigned int node, int place) {
+    assert(this->is_leaf(node));
+
+    return this->cut(node, this->nodes[node].piece.split_vertically(place));
+}
+
+std::pair<unsigned int, unsigned int> CutPlan::cut_horizontally(unsigned int node, int place) {
+    assert(this->is_leaf(node));
+
+    return this->cut(node, this->nodes[node].piece.split_horizontally(place));
+}
+
+void CutPlan::undo(unsigned int node) {
+    assert(node < this->nodes.size());
+
+    std::vector<unsigned int> stack(1, node);
+    while (!stack.empty()) {
+        Node& cut = this->nodes[stack.back()];
+        stack.pop_back();
+        if (cut.children == no_children)
+            continue;
+
+        // Every cut removed from the tree removes one piece of the result.
+        stack.push_back(cut.children);
+        stack.push_back(cut.children + 1);
+        this->free_pairs.push_back(cut.children);
+        this->leaves--;
+        cut.children = no_children;
+    }
+}
+
+Rectangle CutPlan::piece(unsigned int node) const {
+    assert(node < this->nodes.size());
+
+    return this->nodes[node].piece;
+}
+
+bool CutPlan::is_leaf(unsigned int node) const {
+    assert(node < this->nodes.size());
+
+    return this->nodes[node].children == no_children;
+}
+
+unsigned int CutPlan::size() const {
+    return this->leaves;
+}
+
+void CutPlan::execute(Rectangles& recs) const {
+    this->for_each_piece([&recs](const Rectangle& rec) { recs.push_back(rec); });
+}
+
+Rectangles CutPlan::execute() const {
+    Rectangles recs;
+    this->execute(recs);
+    return recs;
+}
@@ -0,0 +1,117 @@
+#ifndef CUT_PLAN_H
+#define CUT_PLAN_H
+
+
+#include <utility>
+#include <vector>
+#include "geometry.h"
+
+/**
+ * Plan of guillotine cuts of one rectangle, kept as a binary tree.
+ * Every node is a piece of the rectangle: a leaf is a piece of the
+ * result, other nodes are cut into two children.
+ *
+ * The pieces of the result are the leaves from left to right, which is
+ * the order in which Rectangles::split_vertically and
+ * Rectangles::split_horizontally would leave them after the same cuts.
+ * The plan is a flat array, so copying it to try an alternative is cheap.
+ */
+class CutPlan
+{
+private:
+    struct Node
+    {
+        Rectangle piece;
+
+        // Number of the first child, the second follows it,
+        // or no_children for a leaf.
+        unsigned int children;
+    };
+
+    static const unsigned int no_children = -1;
+
+    std::vector<Node> nodes;
+
+    // First children of the pairs of nodes removed by undo.
+    std::vector<unsigned int> free_pairs;
+    unsigned int leaves;
+
+    std::pair<unsigned int, unsigned int> cut(unsigned int, const std::pair<Rectangle, Rectangle>&);
+
+public:
+    /**
+     * Plan with no cuts, whose only piece is the given rectangle,
+     * with number 0.
+     */
+    explicit CutPlan(const Rectangle&);
+
+    /**
+     * Cut the piece along the vertical axis.
+     * @param node - number of a piece without cuts
+     * @param place - place of the cut, as in Rectangle::split_vertically
+     * @return numbers of the left and the right piece
+     */
+    std::pair<unsigned int, unsigned int> cut_vertically(unsigned int, int);
+
+    /**
+     * Cut the piece along the horizontal axis.
+     * @param node - number of a piece without cuts
+     * @param place - level of the cut, as in Rectangle::split_horizontally
+     * @return numbers of the lower and the upper piece
+     */
+    std::pair<unsigned int, unsigned int> cut_horizontally(unsigned int, int);
+
+    /**
+     * Remove all cuts made in the piece and in its parts. The numbers
+     * of its parts are no longer valid and may be given to new pieces.
+     */
+    void undo(unsigned int);
+
+    /**
+     * @return the piece with the given number
+     */
+    Rectangle piece(unsigned int) const;
+
+    /**
+     * @return whether the piece is not cut
+     */
+    bool is_leaf(unsigned int) const;
+
+    /**
+     * @return number of the pieces of the result
+     */
+    unsigned int size() const;
+
+    /**
+     * Call f(piece) on the pieces of the result, in their order,
+     * without building a container.
+     */
+    template <typename F>
+    void for_each_piece(F f) const {
+        // The tree may be as deep as the number of the cuts,
+        // so it is walked with an explicit stack.
+        std::vector<unsigned int> stack(1, 0);
+        while (!stack.empty()) {
+            const Node& node = this->nodes[stack.back()];
+            stack.pop_back();
+            if (node.children == no_children) {
+                f(node.piece);
+            } else {
+                stack.push_back(node.children + 1);
+                stack.push_back(node.children);
+            }
+        }
+    }
+
+    /**
+     * Add the pieces of the result at the end of the container.
+     */
+    void execute(Rectangles&) const;
+
+    /**
+     * @return container of the pieces of the result
+     */
+    Rectangles execute() const;
+};
+
+#endif /* CUT_PLAN_H */
@@ -1,318 +1,754 @@
+#include <algorithm>
 #include <cassert>
+#include <cstdint>
+#include <limits>
+#include <set>
+#include <thread>
+#include <tuple>
 #include "geometry.h"
+#include "rectangles_coverage.h"
+#include "rectangles_index.h"
 
-Position::Position(const int &x, const int &y) : x_cord(x), y_cord(y) {}
+namespace {
 
-Position::Position(int &&x, int &&y) : x_cord(std::move(x)), y_cord(std::move(y)) {}
+// Stored positions are relative to the offset of the container. Integral
+// ones are added and subtracted in the unsigned type, so that they wrap
+// around instead of overflowing when the offset is large.
 
-Position& Position::operator= (const Position& pos) {
-    if (&pos != this) {
-        this->x_cord = pos.x();
-        this->y_cord = pos.y();
-    }
-    return *this;
+template <typename T>
+T wrapping_add(T a, T b, std::true_type /* integral */) {
+    typedef typename std::make_unsigned<T>::type Unsigned;
+    return (T) (Unsigned) ((Unsigned) a + (Unsigned) b);
 }
 
-bool Position::operator== (Position const & pos) const {
-    return this->x() == pos.x() && this->y() == pos.y();
+template <typename T>
+T wrapping_add(T a, T b, std::false_type /* integral */) {
+    return a + b;
 }
 
-int Position::x() const {
-    return this->x_cord;
+template <typename T>
+T wrapping_add(T a, T b) {
+    return wrapping_add(a, b, std::is_integral<T>());
 }
 
-int &Position::x() {
-    return this->x_cord;
+template <typename T>
+T wrapping_sub(T a, T b, std::true_type /* integral */) {
+    typedef typename std::make_unsigned<T>::type Unsigned;
+    return (T) (Unsigned) ((Unsigned) a - (Unsigned) b);
 }
 
-int Position::y() const {
-    return this->y_cord;
+template <typename T>
+T wrapping_sub(T a, T b, std::false_type /* integral */) {
+    return a - b;
 }
 
-int &Position::y() {
-    return this->y_cord;
+template <typename T>
+T wrapping_sub(T a, T b) {
+    return wrapping_sub(a, b, std::is_integral<T>());
 }
 
-Position Position::reflection() const {
-    return Position(this->y(), this->x());
-}
+}  // namespace
 
-Position& Position::operator+= (Vector const & vec) {
-    this->x_cord += vec.x();
-    this->y_cord += vec.y();
-    return *this;
+template <typename T>
+BasicRectangleRef<T>::BasicRectangleRef(BasicRectangles<T>& recs, unsigned int i) : rectangles(recs), idx(i) {}
+
+template <typename T>
+BasicRectangleRef<T>::operator BasicRectangle<T>() const {
+    const BasicRectangles<T>& recs = this->rectangles;
+    return recs[this->idx];
 }
 
-Position &Position::operator+=(Vector && vec) {
-    this->x_cord += std::move(vec.x());
-    this->y_cord += std::move(vec.y());
+template <typename T>
+BasicRectangleRef<T>& BasicRectangleRef<T>::operator= (const BasicRectangle<T>& rec) {
+    this->rectangles.set(this->idx, rec);
     return *this;
 }
 
-const Position& Position::origin() {
-    static const Position origin_pos = Position(0, 0);
-    return origin_pos;
+template <typename T>
+BasicRectangleRef<T>& BasicRectangleRef<T>::operator= (const BasicRectangleRef<T>& ref) {
+    return *this = BasicRectangle<T>(ref);
 }
 
-Vector::Vector(const int &x, const int &y) : vec_position(x, y) {}
-
-Vector::Vector(int &&x, int &&y) : vec_position(std::move(x), std::move(y)) {}
-
-Vector& Vector::operator= (const Vector& vec) {
-    if (&vec != this) {
-        this->vec_position = Position(vec.x(), vec.y());
-    }
-    return *this;
+template <typename T>
+bool BasicRectangleRef<T>::operator== (const BasicRectangle<T>& rec) const {
+    return BasicRectangle<T>(*this) == rec;
 }
 
-bool Vector::operator== (const Vector& vec) const {
-    return this->vec_position == vec.vec_position;
+template <typename T>
+T BasicRectangleRef<T>::width() const {
+    return this->rectangles.widths[this->rectangles.physical(this->idx)];
 }
 
-int Vector::x() const {
-    return this->vec_position.x();
+template <typename T>
+T BasicRectangleRef<T>::height() const {
+    return this->rectangles.heights[this->rectangles.physical(this->idx)];
 }
 
-int Vector::y() const {
-    return this->vec_position.y();
+template <typename T>
+BasicPosition<T> BasicRectangleRef<T>::pos() const {
+    const BasicRectangles<T>& recs = this->rectangles;
+    return recs[this->idx].pos();
 }
 
-Vector Vector::reflection() const {
-    Position do_reflection = this->vec_position.reflection();
-    return Vector(do_reflection.x(), do_reflection.y());
+template <typename T>
+BasicRectangle<T> BasicRectangleRef<T>::reflection() const {
+    return BasicRectangle<T>(*this).reflection();
 }
 
-Vector& Vector::operator+= (const Vector& vec) {
-    this->vec_position += vec;
+template <typename T>
+BasicRectangleRef<T>& BasicRectangleRef<T>::operator+= (const BasicVector<T>& vec) {
+    this->rectangles.apply_offset();
+    unsigned int i = this->rectangles.physical(this->idx);
+    this->rectangles.xs[i] = wrapping_add(this->rectangles.xs[i], vec.x());
+    this->rectangles.ys[i] = wrapping_add(this->rectangles.ys[i], vec.y());
+    if (this->rectangles.index)
+        this->rectangles.index->set(this->rectangles.ids[i], BasicRectangle<T>(*this));
     return *this;
 }
 
-Rectangle::Rectangle(int x, int y) : bottom_left(0, 0), diagonal_vector(x, y) {  assert(x >= 0 && y >= 0); }
-
-Rectangle::Rectangle(int x, int y, Position const & pos) : bottom_left(std::move(pos.x()), std::move(pos.y())), diagonal_vector(x, y) { assert(x >= 0 && y >= 0); }
-
-Rectangle::Rectangle(int x, int y, Position && pos) : bottom_left(std::move(pos.x()), std::move(pos.y())), diagonal_vector(x, y) { assert (x >=0 && y >= 0); }
-
-Rectangle& Rectangle::operator= (const Rectangle& rec) {
-    if (&rec != this) {
-        this->bottom_left = Position(rec.pos());
-        this->diagonal_vector = Vector(rec.width(), rec.height());
-    }
-    return *this;
+template <typename T>
+AreaType<T> BasicRectangleRef<T>::area() const {
+    return (AreaType<T>) this->width() * this->height();
 }
 
-bool Rectangle::operator== (Rectangle const & rec) const {
-    return this->bottom_left == rec.bottom_left && this->diagonal_vector == rec.diagonal_vector;
+template <typename T>
+std::pair<BasicRectangle<T>, BasicRectangle<T>> BasicRectangleRef<T>::split_horizontally(T place) const {
+    return BasicRectangle<T>(*this).split_horizontally(place);
 }
 
-int Rectangle::width() const {
-    return this->diagonal_vector.x();
+template <typename T>
+std::pair<BasicRectangle<T>, BasicRectangle<T>> BasicRectangleRef<T>::split_vertically(T place) const {
+    return BasicRectangle<T>(*this).split_vertically(place);
 }
 
-int Rectangle::height() const {
-    return this->diagonal_vector.y();
-}
+namespace {
 
-Position Rectangle::pos() const {
-    return this->bottom_left;
-}
+// Kernels over the coordinate arrays. They are plain loops over
+// contiguous coordinates, which the compiler turns into SIMD instructions.
 
-Rectangle Rectangle::reflection() const {
-    Position ref_position = this->bottom_left.reflection();
-    Vector ref_vector = this->diagonal_vector.reflection();
-    return Rectangle(ref_vector.x(), ref_vector.y(), ref_position);
+template <typename T>
+AreaType<T> sum_of_products(const T *__restrict a, const T *__restrict b, unsigned int n) {
+    AreaType<T> sum = 0;
+    for (unsigned int i = 0; i < n; ++i)
+        sum += (AreaType<T>) a[i] * b[i];
+    return sum;
 }
 
-Rectangle& Rectangle::operator+= (const Vector& vec) {
-    this->bottom_left += vec;
-    return *this;
-}
+/**
+ * @return whether a[i] + offset_a == b[i] + offset_b for every i < n
+ */
+template <typename T>
+bool equal_translated(const T *a, T offset_a, const T *b, T offset_b, unsigned int n, std::true_type /* integral */) {
+    typedef typename std::make_unsigned<T>::type Unsigned;
+    Unsigned shift = (Unsigned) offset_a - (Unsigned) offset_b;
+    if (shift == 0)
+        return std::equal(a, a + n, b);
 
-Rectangle& Rectangle::operator+= (Vector && vec) {
-    this->bottom_left += std::move(vec);
-    return *this;
+    // Unsigned arithmetic wraps around like the stored coordinates do.
+    bool equal = true;
+    for (unsigned int i = 0; i < n; ++i)
+        equal &= (Unsigned) ((Unsigned) a[i] + shift) == (Unsigned) b[i];
+    return equal;
 }
 
-int Rectangle::area() const {
-    return this->width() * this->height();
-}
-
-std::pair<Rectangle, Rectangle> Rectangle::split_vertically(int place) const {
-    assert(width() >= place);
-    assert(place >= 0);
-
-    Vector rec1_vec = Vector(place, this->diagonal_vector.y());
-    Rectangle rec1(rec1_vec.x(), rec1_vec.y(), this->bottom_left);
+template <typename T>
+bool equal_translated(const T *a, T offset_a, const T *b, T offset_b, unsigned int n, std::false_type /* integral */) {
+    if (offset_a == offset_b)
+        return std::equal(a, a + n, b);
 
-    Position rec2_bottom_left = Position(this->bottom_left.x() + place, this->bottom_left.y());
-    Vector rec2_vec = Vector(this->diagonal_vector.x() - place, this->diagonal_vector.y());
-    Rectangle rec2(rec2_vec.x(), rec2_vec.y(), rec2_bottom_left);
-    return std::make_pair(rec1, rec2);
+    // Rounded sums are compared, as they are read by operator[].
+    bool equal = true;
+    for (unsigned int i = 0; i < n; ++i)
+        equal &= a[i] + offset_a == b[i] + offset_b;
+    return equal;
 }
 
-std::pair<Rectangle, Rectangle> Rectangle::split_horizontally(int place) const {
-    auto rectangle_pair = this->reflection().split_vertically(place);
-    return std::make_pair(rectangle_pair.first.reflection(), rectangle_pair.second.reflection());
+template <typename T>
+bool equal_translated(const T *a, T offset_a, const T *b, T offset_b, unsigned int n) {
+    return equal_translated(a, offset_a, b, offset_b, n, std::is_integral<T>());
 }
 
-Rectangles::Rectangles(const std::initializer_list<Rectangle>& list_of_rectangles) {
-    this->vector_of_rectangles = std::vector<Rectangle>(list_of_rectangles);
-}
+/**
+ * Capacity of the arrays of a container when the first rectangle is added.
+ */
+const unsigned int initial_capacity = 16;
 
-Rectangles::Rectangles() {
-    this->vector_of_rectangles = std::vector<Rectangle>();
-}
+/**
+ * Bulk operations on fewer rectangles run on one thread, because
+ * starting the threads would take longer than the work.
+ */
+const unsigned int parallel_threshold = 1 << 18;
 
-Rectangles& Rectangles::operator= (const Rectangles& recs) {
-    if (&recs != this) {
-        this->vector_of_rectangles.clear();
-        for (unsigned int i = 0; i < recs.size(); ++i)
-            this->vector_of_rectangles.push_back(recs[i]);
+/**
+ * Split [0, n) into consecutive parts and call f(part, begin, end) on
+ * each of them, on separate threads when n is large.
+ * @return number of the parts
+ */
+template <typename F>
+unsigned int for_each_part(unsigned int n, F f) {
+    unsigned int parts = 1;
+    if (n >= parallel_threshold)
+        parts = std::max(1u, std::min(std::thread::hardware_concurrency(), n / (parallel_threshold / 4)));
+    if (parts == 1) {
+        f(0u, 0u, n);
+        return 1;
     }
-    return *this;
-}
 
-const Rectangle& Rectangles::operator[](unsigned int i) const {
-    return this->vector_of_rectangles[i];
+    std::vector<std::thread> threads;
+    for (unsigned int part = 1; part < parts; ++part) {
+        unsigned int begin = (unsigned long long) n * part / parts;
+        unsigned int end = (unsigned long long) n * (part + 1) / parts;
+        threads.emplace_back(f, part, begin, end);
+    }
+    f(0u, 0u, (unsigned int) ((unsigned long long) n / parts));
+    for (std::thread& thread : threads)
+        thread.join();
+    return parts;
 }
 
-Rectangle& Rectangles::operator[](unsigned int i) {
-    assert(i >= 0);
-    assert(i < vector_of_rectangles.size());
+}  // namespace
 
-    return this->vector_of_rectangles[i];
+template <typename T>
+BasicRectangles<T>::BasicRectangles(const std::initializer_list<BasicRectangle<T>>& list_of_rectangles)
+        : gap_begin(0), gap_end(0), offset_x(0), offset_y(0) {
+    for (const BasicRectangle<T>& rec : list_of_rectangles)
+        this->push_back(rec);
 }
 
-unsigned int Rectangles::size() const {
-    return (unsigned int) this->vector_of_rectangles.size();
-}
+template <typename T>
+BasicRectangles<T>::BasicRectangles() : gap_begin(0), gap_end(0), offset_x(0), offset_y(0) {}
 
-bool Rectangles::operator== (const Rectangles& recs) const {
-    if (this->vector_of_rectangles.size() != recs.vector_of_rectangles.size())
-        return false;
-    for (unsigned int i = 0; i < this->vector_of_rectangles.size(); ++i) {
-        if (!(this->vector_of_rectangles[i] == recs.vector_of_rectangles[i]))
-            return false;
-    }
-    return true;
-}
+template <typename T>
+BasicRectangles<T>::BasicRectangles(RectanglesArena& arena)
+        : xs(&arena), ys(&arena), widths(&arena), heights(&arena),
+          gap_begin(0), gap_end(0), offset_x(0), offset_y(0) {}
 
-Rectangles& Rectangles::operator+= (const Vector& vec) {
-    for (unsigned int i = 0; i < this->vector_of_rectangles.size(); ++i)
-        this->vector_of_rectangles[i] += vec;
-    return *this;
-}
+template <typename T>
+BasicRectangles<T>::BasicRectangles(const BasicRectangles<T>& recs)
+        : xs(recs.xs), ys(recs.ys), widths(recs.widths), heights(recs.heights),
+          gap_begin(recs.gap_begin), gap_end(recs.gap_end),
+          offset_x(recs.offset_x), offset_y(recs.offset_y) {}
 
-Rectangles& Rectangles::operator+= (Vector && vec) {
-    for (unsigned int i = 0; i < this->vector_of_rectangles.size(); ++i)
-        this->vector_of_rectangles[i] += std::move(vec);
-    return *this;
+template <typename T>
+BasicRectangles<T>::BasicRectangles(BasicRectangles<T>&& recs)
+        : xs(std::move(recs.xs)), ys(std::move(recs.ys)),
+          widths(std::move(recs.widths)), heights(std::move(recs.heights)),
+          gap_begin(recs.gap_begin), gap_end(recs.gap_end),
+          offset_x(recs.offset_x), offset_y(recs.offset_y), index(std::move(recs.index)),
+          ids(std::move(recs.ids)), places(std::move(recs.places)) {
+    recs.clear();
 }
 
-std::vector<Rectangle> Rectangles::split_rectangles(unsigned int idx, int place, int how) {
-    assert (idx >= 0 && idx < vector_of_rectangles.size());
+template <typename T>
+BasicRectangles<T>::~BasicRectangles() {}
 
-    std::vector<Rectangle> result = std::vector<Rectangle>();
-    for (unsigned int i = 0; i < vector_of_rectangles.size(); ++i) {
-        if (i != idx)
-            result.push_back(vector_of_rectangles[i]);
-        else {
-            std::pair<Rectangle, Rectangle> new_rectangles = vector_of_rectangles[i].split_horizontally(place);
-            if (!how)
-                new_rectangles = vector_of_rectangles[i].split_vertically(place);
-            result.push_back(new_rectangles.first);
-            result.push_back(new_rectangles.second);
-        }
+template <typename T>
+BasicRectangles<T>& BasicRectangles<T>::operator= (const BasicRectangles<T>& recs) {
+    if (&recs != this) {
+        this->xs = recs.xs;
+        this->ys = recs.ys;
+        this->widths = recs.widths;
+        this->heights = recs.heights;
+        this->gap_begin = recs.gap_begin;
+        this->gap_end = recs.gap_end;
+        this->offset_x = recs.offset_x;
+        this->offset_y = recs.offset_y;
+        this->drop_index();
     }
-    return result;
+    return *this;
 }
 
-void Rectangles::split_vertically(unsigned int idx, int place) {
-    std::vector<Rectangle> new_vector_of_rectangles = split_rectangles(idx, place, 0);
-    this->vector_of_rectangles = new_vector_of_rectangles;
+template <typename T>
+BasicRectangles<T>& BasicRectangles<T>::operator= (BasicRectangles<T>&& recs) {
+    if (&recs != this) {
+        this->xs = std::move(recs.xs);
+        this->ys = std::move(recs.ys);
+        this->widths = std::move(recs.widths);
+        this->heights = std::move(recs.heights);
+        this->gap_begin = recs.gap_begin;
+        this->gap_end = recs.gap_end;
+        this->offset_x = recs.offset_x;
+        this->offset_y = recs.offset_y;
+        this->index = std::move(recs.index);
+        this->ids = std::move(recs.ids);
+        this->places = std::move(recs.places);
+        recs.clear();
+    }
+    return *this;
 }
 
-void Rectangles::split_horizontally(unsigned int idx, int place) {
-    std::vector<Rectangle> new_vector_of_rectangles = split_rectangles(idx, place, 1);
-    this->vector_of_rectangles = new_vector_of_rectangles;
+template <typename T>
+void BasicRectangles<T>::clear() {
+    // Columns left by a move are valid but their state is unspecified.
+    for (Column* column : {&this->xs, &this->ys, &this->widths, &this->heights})
+        column->clear();
+    this->gap_begin = this->gap_end = 0;
+    this->offset_x = this->offset_y = 0;
+    this->drop_index();
 }
 
-Position operator+ (const Position& pos, const Vector& vec) {
-    return Position(pos.x()+vec.x(), pos.y()+vec.y());
+template <typename T>
+unsigned int BasicRectangles<T>::physical(unsigned int i) const {
+    return i < this->gap_begin ? i : i + (this->gap_end - this->gap_begin);
 }
 
-Position&& operator +(Position&& pos, const Vector& vec) {
-    return std::move(pos += vec);
-}
+template <typename T>
+void BasicRectangles<T>::move_gap(unsigned int place) {
+    unsigned int gap = this->gap_end - this->gap_begin;
+    for (Column* column : {&this->xs, &this->ys, &this->widths, &this->heights}) {
+        T* data = column->data();
+        if (place < this->gap_begin)
+            std::copy_backward(data + place, data + this->gap_begin, data + this->gap_end);
+        else
+            std::copy(data + this->gap_end, data + place + gap, data + this->gap_begin);
+    }
 
-Position operator+ (const Vector& vec, const Position& pos) {
-    return pos + vec;
-}
+    if (this->index) {
+        // The ids move with the rectangles, and so do their places.
+        unsigned int* data = this->ids.data();
+        unsigned int moved_begin, moved_end;
+        if (place < this->gap_begin) {
+            std::copy_backward(data + place, data + this->gap_begin, data + this->gap_end);
+            moved_begin = place + gap;
+            moved_end = this->gap_end;
+        } else {
+            std::copy(data + this->gap_end, data + place + gap, data + this->gap_begin);
+            moved_begin = this->gap_begin;
+            moved_end = place;
+        }
+        for (unsigned int p = moved_begin; p < moved_end; ++p)
+            this->places[data[p]] = p;
+    }
+    this->gap_begin = place;
+    this->gap_end = place + gap;
+}
+
+template <typename T>
+void BasicRectangles<T>::insert(unsigned int i, const BasicRectangle<T>& rec) {
+    if (this->gap_begin == this->gap_end) {
+        // The arrays are full: they are doubled and the new cells
+        // become the gap, right at the place of the insertion.
+        unsigned int capacity = (unsigned int) this->xs.size();
+        unsigned int added = capacity < initial_capacity ? initial_capacity : capacity;
+        for (Column* column : {&this->xs, &this->ys, &this->widths, &this->heights})
+            column->insert(column->begin() + i, added, 0);
+        if (this->index) {
+            this->ids.insert(this->ids.begin() + i, added, 0);
+            for (unsigned int p = i + added; p < this->ids.size(); ++p)
+                this->places[this->ids[p]] = p;
+        }
+        this->gap_begin = i;
+        this->gap_end = i + added;
+    } else if (i != this->gap_begin) {
+        this->move_gap(i);
+    }
 
-Position&& operator+ (const Vector& vec, Position&& pos) {
-    return std::move(pos += vec);
+    this->gap_begin++;
+    if (this->index) {
+        this->ids[i] = (unsigned int) this->places.size();
+        this->places.push_back(i);
+    }
+    this->set(i, rec);
+}
+
+template <typename T>
+BasicRectangle<T> BasicRectangles<T>::operator[](unsigned int i) const {
+    assert(i < this->size());
+
+    unsigned int p = this->physical(i);
+    return BasicRectangle<T>(this->widths[p], this->heights[p],
+                     BasicPosition<T>(wrapping_add(this->xs[p], this->offset_x), wrapping_add(this->ys[p], this->offset_y)));
+}
+
+template <typename T>
+BasicRectangleRef<T> BasicRectangles<T>::operator[](unsigned int i) {
+    assert(i < this->size());
+
+    this->apply_offset();
+    return BasicRectangleRef<T>(*this, i);
+}
+
+template <typename T>
+unsigned int BasicRectangles<T>::size() const {
+    return (unsigned int) this->xs.size() - (this->gap_end - this->gap_begin);
+}
+
+template <typename T>
+void BasicRectangles<T>::push_back(const BasicRectangle<T>& rec) {
+    this->insert(this->size(), rec);
+}
+
+template <typename T>
+AreaType<T> BasicRectangles<T>::total_area() const {
+    std::vector<AreaType<T>> sums(std::thread::hardware_concurrency() + 1);
+    unsigned int parts = for_each_part(this->size(), [this, &sums](unsigned int part, unsigned int begin, unsigned int end) {
+        AreaType<T> sum = 0;
+        this->for_each_run(begin, end, [this, &sum](unsigned int p, unsigned int, unsigned int n) {
+            sum += sum_of_products(this->widths.data() + p, this->heights.data() + p, n);
+        });
+        sums[part] = sum;
+    });
+
+    AreaType<T> sum = 0;
+    for (unsigned int part = 0; part < parts; ++part)
+        sum += sums[part];
+    return sum;
+}
+
+template <typename T>
+BasicRectangle<T> BasicRectangles<T>::bounding_box() const {
+    assert(this->size() > 0);
+
+    struct Box {
+        T x1, y1, x2, y2;
+    };
+    // The boxes are computed from the positions as they are read,
+    // because the stored ones may wrap around the offset.
+    std::vector<Box> boxes(std::thread::hardware_concurrency() + 1);
+    unsigned int parts = for_each_part(this->size(), [this, &boxes](unsigned int part, unsigned int begin, unsigned int end) {
+        unsigned int first = this->physical(begin);
+        T first_x = wrapping_add(this->xs[first], this->offset_x);
+        T first_y = wrapping_add(this->ys[first], this->offset_y);
+        Box box = {first_x, first_y, first_x, first_y};
+        this->for_each_run(begin, end, [this, &box](unsigned int p, unsigned int, unsigned int n) {
+            for (unsigned int i = p; i < p + n; ++i) {
+                T x = wrapping_add(this->xs[i], this->offset_x);
+                T y = wrapping_add(this->ys[i], this->offset_y);
+                box.x1 = std::min(box.x1, x);
+                box.y1 = std::min(box.y1, y);
+                box.x2 = std::max(box.x2, wrapping_add(x, this->widths[i]));
+                box.y2 = std::max(box.y2, wrapping_add(y, this->heights[i]));
+            }
+        });
+        boxes[part] = box;
+    });
+
+    Box box = boxes[0];
+    for (unsigned int part = 1; part < parts; ++part) {
+        box.x1 = std::min(box.x1, boxes[part].x1);
+        box.y1 = std::min(box.y1, boxes[part].y1);
+        box.x2 = std::max(box.x2, boxes[part].x2);
+        box.y2 = std::max(box.y2, boxes[part].y2);
+    }
+    return BasicRectangle<T>(box.x2 - box.x1, box.y2 - box.y1, BasicPosition<T>(box.x1, box.y1));
+}
+
+template <typename T>
+BasicRectangles<T> BasicRectangles<T>::filter(const std::function<bool(const BasicRectangle<T>&)>& predicate) const {
+    // Every part collects the numbers of its chosen rectangles, then
+    // they are copied in order.
+    std::vector<std::vector<unsigned int>> chosen(std::thread::hardware_concurrency() + 1);
+    unsigned int parts = for_each_part(this->size(), [this, &chosen, &predicate](unsigned int part, unsigned int begin, unsigned int end) {
+        for (unsigned int i = begin; i < end; ++i)
+            if (predicate((*this)[i]))
+                chosen[part].push_back(i);
+    });
+
+    RectanglesArena* arena = this->xs.get_allocator().arena();
+    BasicRectangles<T> result = arena == nullptr ? BasicRectangles<T>() : BasicRectangles<T>(*arena);
+    for (unsigned int part = 0; part < parts; ++part)
+        for (unsigned int i : chosen[part])
+            result.push_back((*this)[i]);
+    return result;
 }
 
-Vector operator+ (const Vector& vec1, const Vector& vec2) {
-    return Vector(vec1.x()+vec2.x(), vec1.y()+vec2.y());
+template <typename T>
+void BasicRectangles<T>::set(unsigned int i, const BasicRectangle<T>& rec) {
+    this->apply_offset();
+    unsigned int p = this->physical(i);
+    this->xs[p] = wrapping_sub(rec.pos().x(), this->offset_x);
+    this->ys[p] = wrapping_sub(rec.pos().y(), this->offset_y);
+    this->widths[p] = rec.width();
+    this->heights[p] = rec.height();
+    if (this->index)
+        this->index->set(this->ids[p], rec);
+}
+
+template <typename T>
+void BasicRectangles<T>::apply_offset() {
+    if (std::is_integral<T>::value || (this->offset_x == 0 && this->offset_y == 0))
+        return;
+
+    // The cells of the gap are moved too, which does no harm.
+    T offset_x = this->offset_x, offset_y = this->offset_y;
+    for_each_part((unsigned int) this->xs.size(), [this, offset_x, offset_y](unsigned int, unsigned int begin, unsigned int end) {
+        for (unsigned int i = begin; i < end; ++i) {
+            this->xs[i] += offset_x;
+            this->ys[i] += offset_y;
+        }
+    });
+    this->offset_x = this->offset_y = 0;
 }
 
-Vector&& operator+ (Vector&& vec1, const Vector& vec2) {
-    return std::move(vec1 += vec2);
-}
+template <typename T>
+bool BasicRectangles<T>::operator== (const BasicRectangles<T>& recs) const {
+    if (this->size() != recs.size())
+        return false;
 
-Vector&& operator+ (const Vector& vec1, Vector&& vec2) {
-    return std::move(vec2 += vec1);
+    // The gaps of the containers may be at different places, so the
+    // pieces of both are compared pairwise. The stored positions differ
+    // by the difference of the offsets of the containers.
+    std::vector<char> equal_parts(std::thread::hardware_concurrency() + 1);
+    unsigned int parts = for_each_part(this->size(), [&](unsigned int part, unsigned int begin, unsigned int end) {
+        bool equal = true;
+        this->for_each_run(begin, end, [&](unsigned int p, unsigned int i, unsigned int n) {
+            recs.for_each_run(i, i + n, [&](unsigned int q, unsigned int j, unsigned int m) {
+                unsigned int r = p + (j - i);
+                equal = equal &&
+                        equal_translated(recs.xs.data() + q, recs.offset_x, this->xs.data() + r, this->offset_x, m) &&
+                        equal_translated(recs.ys.data() + q, recs.offset_y, this->ys.data() + r, this->offset_y, m) &&
+                        std::equal(recs.widths.data() + q, recs.widths.data() + q + m, this->widths.data() + r) &&
+                        std::equal(recs.heights.data() + q, recs.heights.data() + q + m, this->heights.data() + r);
+            });
+        });
+        equal_parts[part] = equal;
+    });
+    return std::all_of(equal_parts.begin(), equal_parts.begin() + parts, [](char equal) { return equal; });
+}
+
+template <typename T>
+BasicRectangles<T>& BasicRectangles<T>::operator+= (const BasicVector<T>& vec) {
+    this->offset_x = wrapping_add(this->offset_x, vec.x());
+    this->offset_y = wrapping_add(this->offset_y, vec.y());
+    if (this->index)
+        this->index->translate(vec);
+    return *this;
 }
 
-Vector&& operator+ (Vector&& vec1, Vector&& vec2) {
-    return std::move(vec1 += vec2);
-}
+template <typename T>
+BasicRectangles<T>& BasicRectangles<T>::operator+= (BasicVector<T> && vec) {
+    return *this += vec;
+}
+
+template <typename T>
+void BasicRectangles<T>::split_rectangles(unsigned int idx, T place, int how) {
+    assert (idx < this->size());
+
+    BasicRectangle<T> rec = (*this)[idx];
+    std::pair<BasicRectangle<T>, BasicRectangle<T>> new_rectangles =
+        how ? rec.split_horizontally(place) : rec.split_vertically(place);
+
+    this->set(idx, new_rectangles.first);
+    this->insert(idx + 1, new_rectangles.second);
+}
+
+template <typename T>
+void BasicRectangles<T>::split_vertically(unsigned int idx, T place) {
+    split_rectangles(idx, place, 0);
+}
+
+template <typename T>
+void BasicRectangles<T>::split_horizontally(unsigned int idx, T place) {
+    split_rectangles(idx, place, 1);
+}
+
+namespace {
+
+/**
+ * Merge pairs of the rectangles which together form a rectangle, until
+ * no such pair is left. The rectangle merged from a pair takes the place
+ * of the one of them that comes first in the vector, the other is removed
+ * and the order is kept.
+ * @return whether any rectangles were merged
+ */
+template <typename T>
+bool merge_adjacent(std::vector<BasicRectangle<T>>& recs) {
+    // Edges of the rectangles: the position and the length of the side
+    // along the edge, the position of the edge across it, and the number
+    // of the rectangle. Two rectangles merge when the top or the right
+    // edge of one is the bottom or the left edge of the other.
+    typedef std::tuple<T, T, AreaType<T>, unsigned int> Edge;
+    std::set<Edge> bottoms, tops, lefts, rights;
+    auto update = [&](unsigned int i, bool add) {
+        const BasicRectangle<T>& rec = recs[i];
+        std::pair<std::set<Edge>*, Edge> edges[] = {
+            {&bottoms, Edge(rec.pos().x(), rec.width(), rec.pos().y(), i)},
+            {&tops, Edge(rec.pos().x(), rec.width(), (AreaType<T>) rec.pos().y() + rec.height(), i)},
+            {&lefts, Edge(rec.pos().y(), rec.height(), rec.pos().x(), i)},
+            {&rights, Edge(rec.pos().y(), rec.height(), (AreaType<T>) rec.pos().x() + rec.width(), i)}};
+        for (auto& edge : edges) {
+            if (add)
+                edge.first->insert(edge.second);
+            else
+                edge.first->erase(edge.second);
+        }
+    };
+
+    // A rectangle other than i with the edge, or i if there is none.
+    // A rectangle of zero height or width has its own edge on both sides.
+    auto find = [](const std::set<Edge>& edges, T along, T length, AreaType<T> across, unsigned int i) {
+        for (auto edge = edges.lower_bound(Edge(along, length, across, 0));
+             edge != edges.end() && std::get<0>(*edge) == along && std::get<1>(*edge) == length && std::get<2>(*edge) == across;
+             ++edge)
+            if (std::get<3>(*edge) != i)
+                return std::get<3>(*edge);
+        return i;
+    };
+
+    // Rectangles merged in one direction may become mergeable in the
+    // other, so every merged rectangle is checked again. Every check
+    // takes O(log n) time and there are at most n merges.
+    std::vector<char> removed(recs.size());
+    std::vector<unsigned int> pending;
+    for (unsigned int i = (unsigned int) recs.size(); i-- > 0;) {
+        update(i, true);
+        pending.push_back(i);
+    }
+    bool merged = false;
+    while (!pending.empty()) {
+        unsigned int i = pending.back();
+        pending.pop_back();
+        if (removed[i])
+            continue;
+
+        const BasicRectangle<T> rec = recs[i];
+        unsigned int j;
+        BasicRectangle<T> result = rec;
+        if ((j = find(bottoms, rec.pos().x(), rec.width(), (AreaType<T>) rec.pos().y() + rec.height(), i)) != i)
+            result = merge_horizontally(rec, recs[j]);
+        else if ((j = find(tops, rec.pos().x(), rec.width(), rec.pos().y(), i)) != i)
+            result = merge_horizontally(recs[j], rec);
+        else if ((j = find(lefts, rec.pos().y(), rec.height(), (AreaType<T>) rec.pos().x() + rec.width(), i)) != i)
+            result = merge_vertically(rec, recs[j]);
+        else if ((j = find(rights, rec.pos().y(), rec.height(), rec.pos().x(), i)) != i)
+            result = merge_vertically(recs[j], rec);
+        else
+            continue;
+
+        update(i, false);
+        update(j, false);
+        unsigned int first = std::min(i, j);
+        recs[first] = result;
+        removed[std::max(i, j)] = true;
+        update(first, true);
+        pending.push_back(first);
+        merged = true;
+    }
 
-Rectangle operator+ (const Rectangle& rec, const Vector& vec) {
-    return Rectangle(rec.width(), rec.height(), rec.pos()+vec);
+    if (merged) {
+        unsigned int kept = 0;
+        for (unsigned int i = 0; i < recs.size(); ++i)
+            if (!removed[i])
+                recs[kept++] = recs[i];
+        recs.erase(recs.begin() + kept, recs.end());
+    }
+    return merged;
+}
+
+}  // namespace
+
+template <typename T>
+void BasicRectangles<T>::coalesce() {
+    std::vector<BasicRectangle<T>> recs;
+    recs.reserve(this->size());
+    for (unsigned int i = 0; i < this->size(); ++i)
+        recs.push_back((*this)[i]);
+    if (!merge_adjacent(recs))
+        return;
+
+    RectanglesArena* arena = this->xs.get_allocator().arena();
+    BasicRectangles<T> result = arena == nullptr ? BasicRectangles<T>() : BasicRectangles<T>(*arena);
+    for (const BasicRectangle<T>& rec : recs)
+        result.push_back(rec);
+    *this = std::move(result);
+}
+
+template <typename T>
+const BasicRectanglesIndex<T>& BasicRectangles<T>::spatial_index() const {
+    if (!this->index) {
+        // The index is built with the numbers of the rectangles as ids.
+        unsigned int n = this->size();
+        this->ids.assign(this->xs.size(), 0);
+        this->places.resize(n);
+        for (unsigned int i = 0; i < n; ++i) {
+            this->ids[this->physical(i)] = i;
+            this->places[i] = this->physical(i);
+        }
+        this->index.reset(new BasicRectanglesIndex<T>(*this));
+    }
+    return *this->index;
 }
 
-Rectangle&& operator+ (Rectangle&& rec, const Vector& vec) {
-    return std::move(rec += vec);
+template <typename T>
+void BasicRectangles<T>::drop_index() {
+    this->index.reset();
+    this->ids.clear();
+    this->places.clear();
 }
 
-Rectangle operator+ (const Vector& vec, const Rectangle& rec) {
-    return rec + vec;
+template <typename T>
+std::vector<unsigned int> BasicRectangles<T>::numbers(const std::vector<unsigned int>& found) const {
+    std::vector<unsigned int> result;
+    result.reserve(found.size());
+    for (unsigned int id : found) {
+        unsigned int p = this->places[id];
+        result.push_back(p < this->gap_begin ? p : p - (this->gap_end - this->gap_begin));
+    }
+    return result;
 }
 
-Rectangle&& operator+ (const Vector& vec, Rectangle&& rec) {
-    return std::move(rec += vec);
+template <typename T>
+std::vector<unsigned int> BasicRectangles<T>::containing(const BasicPosition<T>& pos) const {
+    std::vector<unsigned int> result = this->numbers(this->spatial_index().containing(pos));
+    std::sort(result.begin(), result.end());
+    return result;
 }
 
-Rectangles operator+ (const Rectangles& recs, const Vector& vec) {
-    Rectangles result_recs = recs;
-    for (unsigned int i = 0; i < recs.size(); ++i)
-        result_recs[i] += vec;
-    return result_recs;
+template <typename T>
+std::vector<unsigned int> BasicRectangles<T>::overlapping(const BasicRectangle<T>& rec) const {
+    std::vector<unsigned int> result = this->numbers(this->spatial_index().overlapping(rec));
+    std::sort(result.begin(), result.end());
+    return result;
 }
 
-Rectangles&& operator+ (Rectangles&& recs, const Vector& vec) {
-    return std::move(recs += vec);
+template <typename T>
+std::vector<unsigned int> BasicRectangles<T>::nearest(const BasicPosition<T>& pos, unsigned int k) const {
+    return this->numbers(this->spatial_index().nearest(pos, k));
 }
 
-Rectangles operator+ (const Vector& vec, const Rectangles& recs) {
-    return recs + vec;
+template <typename T>
+AreaType<T> BasicRectangles<T>::union_area() const {
+    return BasicRectanglesCoverage<T>(*this).union_area();
 }
 
-Rectangles&& operator+ (const Vector& vec, Rectangles&& recs) {
-    return std::move(recs += vec);
+template <typename T>
+AreaType<T> BasicRectangles<T>::overlap_area() const {
+    return BasicRectanglesCoverage<T>(*this).overlap_area();
 }
 
-Rectangle merge_horizontally(const Rectangle& rec1, const Rectangle& rec2) {
-    assert(rec2.pos().y() == rec1.pos().y() + rec1.height());
-    assert(rec1.width() == rec2.width());
-    assert(rec1.pos().x() == rec2.pos().x());
+template <typename T>
+bool BasicRectangles<T>::is_tiling() const {
+    if (this->size() == 0)
+        return true;
 
-    return Rectangle(rec1.width(), rec1.height()+rec2.height(), rec1.pos());
-}
+    BasicRectanglesCoverage<T> coverage(*this);
+    BasicRectangle<T> box = this->bounding_box();
+    AreaType<T> area = box.area();
 
-Rectangle merge_vertically(const Rectangle& rec1, const Rectangle& rec2) {
-    Rectangle refl_result = merge_horizontally(rec1.reflection(), rec2.reflection());
-    return refl_result.reflection();
+    // Sides of floating-point rectangles which should meet may miss each
+    // other by a rounding error of the coordinates, which changes the
+    // areas by at most that error times the sides of the bounding box
+    // for every rectangle.
+    AreaType<T> tolerance = 0;
+    if (std::is_floating_point<T>::value) {
+        auto magnitude = [](AreaType<T> value) { return value < 0 ? -value : value; };
+        AreaType<T> scale = std::max(std::max(magnitude(box.pos().x()), magnitude((AreaType<T>) box.pos().x() + box.width())),
+                                     std::max(magnitude(box.pos().y()), magnitude((AreaType<T>) box.pos().y() + box.height())));
+        tolerance = 4 * (AreaType<T>) this->size() * std::numeric_limits<T>::epsilon() * scale *
+                    ((AreaType<T>) box.width() + box.height());
+    }
+    AreaType<T> union_area = coverage.union_area();
+    return coverage.overlap_area() <= tolerance && area - tolerance <= union_area && union_area <= area + tolerance;
 }
+
+template class BasicRectangleRef<int16_t>;
+template class BasicRectangleRef<int>;
+template class BasicRectangleRef<int64_t>;
+template class BasicRectangleRef<float>;
+template class BasicRectangleRef<double>;
+
+template class BasicRectangles<int16_t>;
+template class BasicRectangles<int>;
+template class BasicRectangles<int64_t>;
+template class BasicRectangles<float>;
+template class BasicRectangles<double>;
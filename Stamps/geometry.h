@@ -2,147 +2,361 @@
 #define GEOMETRY_H
 
 
+#include <cassert>
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <utility>
 #include <vector>
+#include "rectangles_arena.h"
+
+/**
+ * Type of the areas of rectangles with 64-bit coordinates: __int128, an
+ * extension of GCC and Clang, where the compiler has it, otherwise long
+ * double, whose areas are exact up to 2^64 and rounded above.
+ */
+#ifdef __SIZEOF_INT128__
+typedef __int128 WideAreaType;
+#else
+typedef long double WideAreaType;
+#endif
+
+/**
+ * Type of the areas of rectangles with coordinates of type T, wide
+ * enough for products of two coordinates: long long for coordinates of
+ * up to 32 bits and WideAreaType for 64-bit ones. Sums of areas overflow
+ * only when the total does not fit the type, as for single rectangles.
+ */
+template <typename T>
+using AreaType = typename std::conditional<std::is_floating_point<T>::value,
+                                           typename std::common_type<T, double>::type,
+                                           typename std::conditional<(sizeof(T) > 4), WideAreaType, long long>::type>::type;
 
 /**
  * Represent a point on the plane.
  */
-class Position;
-class Vector;
-class Rectangle;
+template <typename T> class BasicPosition;
+template <typename T> class BasicVector;
+template <typename T> class BasicRectangle;
 
 /**
  * Represent a conatiner of the rectangles.
  */
-class Rectangles;
+template <typename T> class BasicRectangles;
 
-class Position
+/**
+ * Represent a rectangle stored in the container.
+ */
+template <typename T> class BasicRectangleRef;
+
+/**
+ * Spatial index over the rectangles of a container.
+ */
+template <typename T> class BasicRectanglesIndex;
+
+/**
+ * The geometry classes are templates over the type T of the coordinates,
+ * defined for int16_t, int, int64_t, float and double. The names
+ * without the Basic prefix are the classes with int coordinates.
+ */
+typedef BasicPosition<int> Position;
+typedef BasicVector<int> Vector;
+typedef BasicRectangle<int> Rectangle;
+typedef BasicRectangles<int> Rectangles;
+typedef BasicRectangleRef<int> RectangleRef;
+typedef BasicRectanglesIndex<int> RectanglesIndex;
+
+template <typename T>
+class BasicPosition
 {
 private:
-    int x_cord, y_cord;
+    T x_cord, y_cord;
 
 public:
-    Position(const int&, const int&);
-    Position(int&&, int&&);
-    Position &operator= (const Position&);
-    bool operator== (const Position&) const;
-    int x() const;
-    int& x();
-    int y() const;
-    int& y();
+    constexpr BasicPosition(const T&, const T&);
+    constexpr BasicPosition(T&&, T&&);
+    constexpr bool operator== (const BasicPosition&) const;
+    constexpr T x() const;
+    constexpr T& x();
+    constexpr T y() const;
+    constexpr T& y();
     /**
      * Return the point reflected across y=x axis
      */
-    Position reflection() const;
-    Position& operator+= (const Vector&);
-    Position& operator+= (Vector&&);
+    constexpr BasicPosition reflection() const;
+    constexpr BasicPosition& operator+= (const BasicVector<T>&);
+    constexpr BasicPosition& operator+= (BasicVector<T>&&);
 
     /**
      * Return an immutable Point (0, 0)
      */
-    static const Position& origin();
+    static const BasicPosition& origin();
 };
 
-class Vector
+template <typename T>
+class BasicVector
 {
 private:
-    Position vec_position;
+    BasicPosition<T> vec_position;
 
 public:
-    Vector(const int&, const int&);
-    Vector(int&&, int&&);
-    Vector& operator= (const Vector&);
-    bool operator== (const Vector&) const;
-    int x() const;
-    int y() const;
+    constexpr BasicVector(const T&, const T&);
+    constexpr BasicVector(T&&, T&&);
+    constexpr bool operator== (const BasicVector&) const;
+    constexpr T x() const;
+    constexpr T y() const;
 
     /**
      * Return the vector reflected across y=x axis
      */
-    Vector reflection() const;
-    Vector& operator+= (const Vector&);
+    constexpr BasicVector reflection() const;
+    constexpr BasicVector& operator+= (const BasicVector&);
 };
 
-class Rectangle
+template <typename T>
+class BasicRectangle
 {
 private:
-    Position bottom_left;
-    Vector diagonal_vector;
+    BasicPosition<T> bottom_left;
+    BasicVector<T> diagonal_vector;
 
 public:
     /**
      * @param width of the rectangle (non-negative)
      * @param height of the rectangle (non-negative)
      */
-    Rectangle(int, int);
+    constexpr BasicRectangle(T, T);
 
     /**
      * @param width of the rectangle
      * @param height of the rectangle
      * @param position of the left bottom vertex
      */
-    Rectangle(int, int, const Position&);
-    Rectangle(int, int, Position&&);
-    Rectangle& operator= (const Rectangle&);
-    bool operator== (const Rectangle&) const;
-    int width() const;
-    int height() const;
-    Position pos() const;
+    constexpr BasicRectangle(T, T, const BasicPosition<T>&);
+    constexpr BasicRectangle(T, T, BasicPosition<T>&&);
+    constexpr bool operator== (const BasicRectangle&) const;
+    constexpr T width() const;
+    constexpr T height() const;
+    constexpr BasicPosition<T> pos() const;
 
     /**
      * Return the rectangle reflected across y=x axis.
      */
-    Rectangle reflection() const;
+    constexpr BasicRectangle reflection() const;
 
     /**
      * Return the rectangle moved by a given vector.
      */
-    Rectangle& operator+= (const Vector&);
-    Rectangle& operator+= (Vector&&);
-    int area() const;
+    constexpr BasicRectangle& operator+= (const BasicVector<T>&);
+    constexpr BasicRectangle& operator+= (BasicVector<T>&&);
+
+    /**
+     * @return area of the rectangle, in the type which does not overflow
+     */
+    constexpr AreaType<T> area() const;
 
     /**
      * Perform a split of the rectangle along the horizontal axis.
      * @param place - level of the split. Place >= 0 and place <= rectangle height.
      * @return pair of the rectangles after the split
      */
-    std::pair<Rectangle, Rectangle> split_horizontally(int) const;
+    constexpr std::pair<BasicRectangle, BasicRectangle> split_horizontally(T) const;
 
     /**
      * Perform a split of the rectangle along the vertical axis.
      * @param place - place of the split. Place >= 0 and place <= rectangle width.
      * @return pair of the rectangles after the split.
      */
-    std::pair<Rectangle, Rectangle> split_vertically(int) const;
+    constexpr std::pair<BasicRectangle, BasicRectangle> split_vertically(T) const;
 };
 
-class Rectangles
+template <typename T>
+class BasicRectangleRef
 {
 private:
-    std::vector<Rectangle> vector_of_rectangles;
-    std::vector<Rectangle> split_rectangles(unsigned int, int, int);
+    BasicRectangles<T>& rectangles;
+    unsigned int idx;
+
+public:
+    BasicRectangleRef(BasicRectangles<T>&, unsigned int);
+    operator BasicRectangle<T>() const;
+
+    /**
+     * Store the given rectangle in place of the referenced one.
+     */
+    BasicRectangleRef& operator= (const BasicRectangle<T>&);
+    BasicRectangleRef& operator= (const BasicRectangleRef&);
+    bool operator== (const BasicRectangle<T>&) const;
+    T width() const;
+    T height() const;
+    BasicPosition<T> pos() const;
+    BasicRectangle<T> reflection() const;
+    BasicRectangleRef& operator+= (const BasicVector<T>&);
+    AreaType<T> area() const;
+    std::pair<BasicRectangle<T>, BasicRectangle<T>> split_horizontally(T) const;
+    std::pair<BasicRectangle<T>, BasicRectangle<T>> split_vertically(T) const;
+};
+
+/**
+ * The coordinates of the rectangles are kept in four separate arrays
+ * (struct of arrays), so that operations on the whole container run
+ * over contiguous coordinates and are vectorized by the compiler.
+ *
+ * The arrays are gap buffers: unused cells are kept together at the
+ * place of the last insertion. A split inserts the second part right
+ * after the split rectangle by moving the gap there, which costs as
+ * much as the distance from the previous split, so sequences of cuts
+ * of neighbouring rectangles take O(1) amortized time per split.
+ *
+ * Translation of the whole container takes O(1) time: the vector is
+ * only added to the offset of the container, which is added to the
+ * positions when they are read and subtracted when they are stored.
+ * Integral positions and offsets are added in the unsigned type, so the
+ * stored positions wrap around instead of overflowing. Floating-point
+ * positions would be rounded when stored relative to the offset, so it
+ * is added to all of them before a rectangle is changed or inserted.
+ *
+ * Comparisons, areas, bounding boxes and filters of containers with
+ * many rectangles are computed on several threads, each of them taking
+ * a contiguous part of the container.
+ *
+ * Point-location and overlap queries use a spatial index built on the
+ * first query. Translations of the whole container shift the index,
+ * splits and changes of single rectangles update it. While the index
+ * exists, every rectangle has an id kept next to its coordinates, and
+ * the place of every id is followed as the gap moves, so the ids found
+ * in the index are turned into numbers in O(1) time. Building the index
+ * changes the container, so the first query must not run concurrently
+ * with other operations on it. Coalescing and assignments drop the index.
+ *
+ * Union and overlap areas are computed by a sweep line in O(n log n)
+ * time, the tiling check takes one such sweep.
+ */
+template <typename T>
+class BasicRectangles
+{
+private:
+    typedef std::vector<T, ArenaAllocator<T>> Column;
+
+    Column xs, ys, widths, heights;
+    unsigned int gap_begin, gap_end;
+
+    // Translation of the whole container, added to the stored positions
+    // when they are read.
+    T offset_x, offset_y;
+    mutable std::unique_ptr<BasicRectanglesIndex<T>> index;
+
+    // Ids of the rectangles in the layout of the coordinate arrays and
+    // the place of every id in the arrays, kept while the index exists.
+    mutable std::vector<unsigned int> ids, places;
+
+    unsigned int physical(unsigned int) const;
+    void move_gap(unsigned int);
+    void insert(unsigned int, const BasicRectangle<T>&);
+    void split_rectangles(unsigned int, T, int);
+    void set(unsigned int, const BasicRectangle<T>&);
+
+    /**
+     * Add the offset to the stored positions of floating-point type.
+     */
+    void apply_offset();
+    const BasicRectanglesIndex<T>& spatial_index() const;
+    void drop_index();
+
+    /**
+     * @return numbers of the rectangles with the given ids
+     */
+    std::vector<unsigned int> numbers(const std::vector<unsigned int>&) const;
+
+    /**
+     * Call f(physical, logical, length) on every contiguous piece
+     * of the arrays holding the rectangles [begin, end).
+     */
+    template <typename F>
+    void for_each_run(unsigned int begin, unsigned int end, F f) const {
+        if (begin < this->gap_begin) {
+            unsigned int stop = end < this->gap_begin ? end : this->gap_begin;
+            f(begin, begin, stop - begin);
+            begin = stop;
+        }
+        if (begin < end)
+            f(this->physical(begin), begin, end - begin);
+    }
+
+    friend class BasicRectangleRef<T>;
 
 public:
     /**
      * Container of the rectangles initialized with the list.
      */
-    Rectangles(const std::initializer_list<Rectangle>&);
+    BasicRectangles(const std::initializer_list<BasicRectangle<T>>&);
 
     /**
      * Empty rectangles container.
      */
-    Rectangles();
-    Rectangles& operator= (const Rectangles&);
-    const Rectangle& operator[](unsigned int) const;
-    Rectangle& operator[](unsigned int);
+    BasicRectangles();
+
+    /**
+     * Empty rectangles container keeping its rectangles in the arena.
+     * Copies of the container use the same arena.
+     */
+    explicit BasicRectangles(RectanglesArena&);
+    BasicRectangles(const BasicRectangles&);
+
+    /**
+     * Take the rectangles and the arena of the container, leaving it empty.
+     */
+    BasicRectangles(BasicRectangles&&);
+    ~BasicRectangles();
+    BasicRectangles& operator= (const BasicRectangles&);
+    BasicRectangles& operator= (BasicRectangles&&);
+
+    /**
+     * @return copy of the rectangle with the given number
+     */
+    BasicRectangle<T> operator[](unsigned int) const;
+
+    /**
+     * @return reference through which the rectangle can be modified
+     */
+    BasicRectangleRef<T> operator[](unsigned int);
 
     /**
      * @return number of the rectangles in the container
      */
     unsigned int size() const;
-    bool operator== (const Rectangles&) const;
-    Rectangles& operator+= (const Vector&);
-    Rectangles& operator+= (Vector&&);
+
+    /**
+     * Add the rectangle at the end of the container.
+     */
+    void push_back(const BasicRectangle<T>&);
+
+    /**
+     * Remove all rectangles from the container.
+     */
+    void clear();
+
+    /**
+     * @return sum of the areas of all rectangles
+     */
+    AreaType<T> total_area() const;
+
+    /**
+     * @return smallest rectangle containing all rectangles of the
+     * non-empty container
+     */
+    BasicRectangle<T> bounding_box() const;
+
+    /**
+     * @param predicate - called for every rectangle, concurrently from
+     * several threads for large containers
+     * @return container of the rectangles satisfying the predicate, in
+     * the same order and in the same arena
+     */
+    BasicRectangles filter(const std::function<bool(const BasicRectangle<T>&)>&) const;
+    bool operator== (const BasicRectangles&) const;
+    BasicRectangles& operator+= (const BasicVector<T>&);
+    BasicRectangles& operator+= (BasicVector<T>&&);
 
     /**
      * Perform the vertical split.
@@ -150,7 +364,7 @@ public:
      * @param place - place of the split
      * Replace the rectangle with the pair after the split in its position in the contatiner.
      */
-    void split_vertically(unsigned int, int);
+    void split_vertically(unsigned int, T);
 
     /**
      * Perform the horizontal split.
@@ -158,29 +372,92 @@ public:
      * @param place - level of the split
      * Replace the rectangle with the pair after the split in its position in the contatiner.
      */
-    void split_horizontally(unsigned int, int);
+    void split_horizontally(unsigned int, T);
+
+    /**
+     * Merge adjacent rectangles which together form a rectangle, until
+     * no two of them can be merged with merge_horizontally or
+     * merge_vertically. A merged rectangle takes the place of the first
+     * of its parts and the order of the others is kept. Takes O(n log n)
+     * time.
+     */
+    void coalesce();
+
+    /**
+     * @return numbers of the rectangles containing the point
+     * (on their boundary too), in increasing order
+     */
+    std::vector<unsigned int> containing(const BasicPosition<T>&) const;
+
+    /**
+     * @return numbers of the rectangles whose interior has common
+     * points with the interior of the given rectangle, in increasing order
+     */
+    std::vector<unsigned int> overlapping(const BasicRectangle<T>&) const;
+
+    /**
+     * @param k - number of the rectangles to find
+     * @return numbers of at most k rectangles nearest to the point, the
+     * nearest first; rectangles containing the point are at distance 0
+     */
+    std::vector<unsigned int> nearest(const BasicPosition<T>&, unsigned int) const;
+
+    /**
+     * @return area covered by the rectangles, counting the parts
+     * covered by several of them once
+     */
+    AreaType<T> union_area() const;
+
+    /**
+     * @return area covered by at least two rectangles
+     */
+    AreaType<T> overlap_area() const;
+
+    /**
+     * @return whether the rectangles cover their bounding box and their
+     * interiors have no common points; true for an empty container.
+     * Floating-point coordinates are compared with a tolerance for
+     * their rounding, proportional to the number of the rectangles.
+     */
+    bool is_tiling() const;
 };
 
-Position operator+ (const Position&, const Vector&);
-Position&& operator+ (Position&&, const Vector&);
-Position&& operator+ (const Vector&, Position&&);
+template <typename T>
+constexpr BasicPosition<T> operator+ (const BasicPosition<T>&, const BasicVector<T>&);
+template <typename T>
+constexpr BasicPosition<T>&& operator+ (BasicPosition<T>&&, const BasicVector<T>&);
+template <typename T>
+constexpr BasicPosition<T>&& operator+ (const BasicVector<T>&, BasicPosition<T>&&);
 
-Position operator+ (const Vector&, const Position&);
+template <typename T>
+constexpr BasicPosition<T> operator+ (const BasicVector<T>&, const BasicPosition<T>&);
 
-Vector operator+ (const Vector&, const Vector&);
-Vector&& operator+ (Vector&&, const Vector&);
-Vector&& operator+ (const Vector&, Vector&&);
-Vector&& operator+ (Vector&&, Vector&&);
+template <typename T>
+constexpr BasicVector<T> operator+ (const BasicVector<T>&, const BasicVector<T>&);
+template <typename T>
+constexpr BasicVector<T>&& operator+ (BasicVector<T>&&, const BasicVector<T>&);
+template <typename T>
+constexpr BasicVector<T>&& operator+ (const BasicVector<T>&, BasicVector<T>&&);
+template <typename T>
+constexpr BasicVector<T>&& operator+ (BasicVector<T>&&, BasicVector<T>&&);
 
-Rectangle operator+ (const Rectangle&, const Vector&);
-Rectangle&& operator+ (Rectangle&&, const Vector&);
-Rectangle operator+ (const Vector&, const Rectangle&);
-Rectangle&& operator+ (const Vector&, Rectangle&&);
+template <typename T>
+constexpr BasicRectangle<T> operator+ (const BasicRectangle<T>&, const BasicVector<T>&);
+template <typename T>
+constexpr BasicRectangle<T>&& operator+ (BasicRectangle<T>&&, const BasicVector<T>&);
+template <typename T>
+constexpr BasicRectangle<T> operator+ (const BasicVector<T>&, const BasicRectangle<T>&);
+template <typename T>
+constexpr BasicRectangle<T>&& operator+ (const BasicVector<T>&, BasicRectangle<T>&&);
 
-Rectangles operator+ (const Rectangles&, const Vector&);
-Rectangles&& operator+ (Rectangles&&, const Vector&);
-Rectangles operator+ (const Vector&, const Rectangles&);
-Rectangles&& operator+ (const Vector&, Rectangles&&);
+template <typename T>
+BasicRectangles<T> operator+ (const BasicRectangles<T>&, const BasicVector<T>&);
+template <typename T>
+BasicRectangles<T> operator+ (BasicRectangles<T>&&, const BasicVector<T>&);
+template <typename T>
+BasicRectangles<T> operator+ (const BasicVector<T>&, const BasicRectangles<T>&);
+template <typename T>
+BasicRectangles<T> operator+ (const BasicVector<T>&, BasicRectangles<T>&&);
 
 /**
  * Merge two rectangles into one.
@@ -188,7 +465,8 @@ Rectangles&& operator+ (const Vector&, Rectangles&&);
  * adjacent.
  * @return merged rectangle
  */
-Rectangle merge_horizontally(const Rectangle&, const Rectangle&);
+template <typename T>
+constexpr BasicRectangle<T> merge_horizontally(const BasicRectangle<T>&, const BasicRectangle<T>&);
 
 /**
  * Merge two rectangles into one.
@@ -196,6 +474,288 @@ Rectangle merge_horizontally(const Rectangle&, const Rectangle&);
  * adjacent.
  * @return merged rectangle
  */
-Rectangle merge_vertically(const Rectangle&, const Rectangle&);
+template <typename T>
+constexpr BasicRectangle<T> merge_vertically(const BasicRectangle<T>&, const BasicRectangle<T>&);
+
+/**
+ * Merge two rectangles of a container, which are not converted to
+ * rectangles when the type of the coordinates is deduced.
+ */
+template <typename T>
+BasicRectangle<T> merge_horizontally(const BasicRectangleRef<T>&, const BasicRectangleRef<T>&);
+template <typename T>
+BasicRectangle<T> merge_vertically(const BasicRectangleRef<T>&, const BasicRectangleRef<T>&);
+
+// Positions, vectors and rectangles are literal types, so that their
+// functions are defined here and can be evaluated at compile time.
+
+template <typename T>
+constexpr BasicPosition<T>::BasicPosition(const T &x, const T &y) : x_cord(x), y_cord(y) {}
+
+template <typename T>
+constexpr BasicPosition<T>::BasicPosition(T &&x, T &&y) : x_cord(std::move(x)), y_cord(std::move(y)) {}
+
+template <typename T>
+constexpr bool BasicPosition<T>::operator== (BasicPosition<T> const & pos) const {
+    return this->x() == pos.x() && this->y() == pos.y();
+}
+
+template <typename T>
+constexpr T BasicPosition<T>::x() const {
+    return this->x_cord;
+}
+
+template <typename T>
+constexpr T &BasicPosition<T>::x() {
+    return this->x_cord;
+}
+
+template <typename T>
+constexpr T BasicPosition<T>::y() const {
+    return this->y_cord;
+}
+
+template <typename T>
+constexpr T &BasicPosition<T>::y() {
+    return this->y_cord;
+}
+
+template <typename T>
+constexpr BasicPosition<T> BasicPosition<T>::reflection() const {
+    return BasicPosition<T>(this->y(), this->x());
+}
+
+template <typename T>
+constexpr BasicPosition<T>& BasicPosition<T>::operator+= (BasicVector<T> const & vec) {
+    this->x_cord += vec.x();
+    this->y_cord += vec.y();
+    return *this;
+}
+
+template <typename T>
+constexpr BasicPosition<T> &BasicPosition<T>::operator+=(BasicVector<T> && vec) {
+    this->x_cord += std::move(vec.x());
+    this->y_cord += std::move(vec.y());
+    return *this;
+}
+
+template <typename T>
+const BasicPosition<T>& BasicPosition<T>::origin() {
+    static const BasicPosition<T> origin_pos = BasicPosition<T>(0, 0);
+    return origin_pos;
+}
+
+template <typename T>
+constexpr BasicVector<T>::BasicVector(const T &x, const T &y) : vec_position(x, y) {}
+
+template <typename T>
+constexpr BasicVector<T>::BasicVector(T &&x, T &&y) : vec_position(std::move(x), std::move(y)) {}
+
+template <typename T>
+constexpr bool BasicVector<T>::operator== (const BasicVector<T>& vec) const {
+    return this->vec_position == vec.vec_position;
+}
+
+template <typename T>
+constexpr T BasicVector<T>::x() const {
+    return this->vec_position.x();
+}
+
+template <typename T>
+constexpr T BasicVector<T>::y() const {
+    return this->vec_position.y();
+}
+
+template <typename T>
+constexpr BasicVector<T> BasicVector<T>::reflection() const {
+    BasicPosition<T> do_reflection = this->vec_position.reflection();
+    return BasicVector<T>(do_reflection.x(), do_reflection.y());
+}
+
+template <typename T>
+constexpr BasicVector<T>& BasicVector<T>::operator+= (const BasicVector<T>& vec) {
+    this->vec_position += vec;
+    return *this;
+}
+
+template <typename T>
+constexpr BasicRectangle<T>::BasicRectangle(T x, T y) : bottom_left(0, 0), diagonal_vector(x, y) {  assert(x >= 0 && y >= 0); }
+
+template <typename T>
+constexpr BasicRectangle<T>::BasicRectangle(T x, T y, BasicPosition<T> const & pos) : bottom_left(std::move(pos.x()), std::move(pos.y())), diagonal_vector(x, y) { assert(x >= 0 && y >= 0); }
+
+template <typename T>
+constexpr BasicRectangle<T>::BasicRectangle(T x, T y, BasicPosition<T> && pos) : bottom_left(std::move(pos.x()), std::move(pos.y())), diagonal_vector(x, y) { assert (x >=0 && y >= 0); }
+
+template <typename T>
+constexpr bool BasicRectangle<T>::operator== (BasicRectangle<T> const & rec) const {
+    return this->bottom_left == rec.bottom_left && this->diagonal_vector == rec.diagonal_vector;
+}
+
+template <typename T>
+constexpr T BasicRectangle<T>::width() const {
+    return this->diagonal_vector.x();
+}
+
+template <typename T>
+constexpr T BasicRectangle<T>::height() const {
+    return this->diagonal_vector.y();
+}
+
+template <typename T>
+constexpr BasicPosition<T> BasicRectangle<T>::pos() const {
+    return this->bottom_left;
+}
+
+template <typename T>
+constexpr BasicRectangle<T> BasicRectangle<T>::reflection() const {
+    BasicPosition<T> ref_position = this->bottom_left.reflection();
+    BasicVector<T> ref_vector = this->diagonal_vector.reflection();
+    return BasicRectangle<T>(ref_vector.x(), ref_vector.y(), ref_position);
+}
+
+template <typename T>
+constexpr BasicRectangle<T>& BasicRectangle<T>::operator+= (const BasicVector<T>& vec) {
+    this->bottom_left += vec;
+    return *this;
+}
+
+template <typename T>
+constexpr BasicRectangle<T>& BasicRectangle<T>::operator+= (BasicVector<T> && vec) {
+    this->bottom_left += std::move(vec);
+    return *this;
+}
+
+template <typename T>
+constexpr AreaType<T> BasicRectangle<T>::area() const {
+    return (AreaType<T>) this->width() * this->height();
+}
+
+template <typename T>
+constexpr std::pair<BasicRectangle<T>, BasicRectangle<T>> BasicRectangle<T>::split_vertically(T place) const {
+    assert(width() >= place);
+    assert(place >= 0);
+
+    BasicVector<T> rec1_vec = BasicVector<T>(place, this->diagonal_vector.y());
+    BasicRectangle<T> rec1(rec1_vec.x(), rec1_vec.y(), this->bottom_left);
+
+    BasicPosition<T> rec2_bottom_left = BasicPosition<T>(this->bottom_left.x() + place, this->bottom_left.y());
+    BasicVector<T> rec2_vec = BasicVector<T>(this->diagonal_vector.x() - place, this->diagonal_vector.y());
+    BasicRectangle<T> rec2(rec2_vec.x(), rec2_vec.y(), rec2_bottom_left);
+    return std::make_pair(rec1, rec2);
+}
+
+template <typename T>
+constexpr std::pair<BasicRectangle<T>, BasicRectangle<T>> BasicRectangle<T>::split_horizontally(T place) const {
+    auto rectangle_pair = this->reflection().split_vertically(place);
+    return std::make_pair(rectangle_pair.first.reflection(), rectangle_pair.second.reflection());
+}
+
+template <typename T>
+constexpr BasicPosition<T> operator+ (const BasicPosition<T>& pos, const BasicVector<T>& vec) {
+    return BasicPosition<T>(pos.x()+vec.x(), pos.y()+vec.y());
+}
+
+template <typename T>
+constexpr BasicPosition<T>&& operator +(BasicPosition<T>&& pos, const BasicVector<T>& vec) {
+    return std::move(pos += vec);
+}
+
+template <typename T>
+constexpr BasicPosition<T> operator+ (const BasicVector<T>& vec, const BasicPosition<T>& pos) {
+    return pos + vec;
+}
+
+template <typename T>
+constexpr BasicPosition<T>&& operator+ (const BasicVector<T>& vec, BasicPosition<T>&& pos) {
+    return std::move(pos += vec);
+}
+
+template <typename T>
+constexpr BasicVector<T> operator+ (const BasicVector<T>& vec1, const BasicVector<T>& vec2) {
+    return BasicVector<T>(vec1.x()+vec2.x(), vec1.y()+vec2.y());
+}
+
+template <typename T>
+constexpr BasicVector<T>&& operator+ (BasicVector<T>&& vec1, const BasicVector<T>& vec2) {
+    return std::move(vec1 += vec2);
+}
+
+template <typename T>
+constexpr BasicVector<T>&& operator+ (const BasicVector<T>& vec1, BasicVector<T>&& vec2) {
+    return std::move(vec2 += vec1);
+}
+
+template <typename T>
+constexpr BasicVector<T>&& operator+ (BasicVector<T>&& vec1, BasicVector<T>&& vec2) {
+    return std::move(vec1 += vec2);
+}
+
+template <typename T>
+constexpr BasicRectangle<T> operator+ (const BasicRectangle<T>& rec, const BasicVector<T>& vec) {
+    return BasicRectangle<T>(rec.width(), rec.height(), rec.pos()+vec);
+}
+
+template <typename T>
+constexpr BasicRectangle<T>&& operator+ (BasicRectangle<T>&& rec, const BasicVector<T>& vec) {
+    return std::move(rec += vec);
+}
+
+template <typename T>
+constexpr BasicRectangle<T> operator+ (const BasicVector<T>& vec, const BasicRectangle<T>& rec) {
+    return rec + vec;
+}
+
+template <typename T>
+constexpr BasicRectangle<T>&& operator+ (const BasicVector<T>& vec, BasicRectangle<T>&& rec) {
+    return std::move(rec += vec);
+}
+
+template <typename T>
+constexpr BasicRectangle<T> merge_horizontally(const BasicRectangle<T>& rec1, const BasicRectangle<T>& rec2) {
+    assert(rec2.pos().y() == rec1.pos().y() + rec1.height());
+    assert(rec1.width() == rec2.width());
+    assert(rec1.pos().x() == rec2.pos().x());
+
+    return BasicRectangle<T>(rec1.width(), rec1.height()+rec2.height(), rec1.pos());
+}
+
+template <typename T>
+constexpr BasicRectangle<T> merge_vertically(const BasicRectangle<T>& rec1, const BasicRectangle<T>& rec2) {
+    BasicRectangle<T> refl_result = merge_horizontally(rec1.reflection(), rec2.reflection());
+    return refl_result.reflection();
+}
+
+template <typename T>
+BasicRectangle<T> merge_horizontally(const BasicRectangleRef<T>& rec1, const BasicRectangleRef<T>& rec2) {
+    return merge_horizontally(BasicRectangle<T>(rec1), BasicRectangle<T>(rec2));
+}
+
+template <typename T>
+BasicRectangle<T> merge_vertically(const BasicRectangleRef<T>& rec1, const BasicRectangleRef<T>& rec2) {
+    return merge_vertically(BasicRectangle<T>(rec1), BasicRectangle<T>(rec2));
+}
+
+template <typename T>
+BasicRectangles<T> operator+ (const BasicRectangles<T>& recs, const BasicVector<T>& vec) {
+    BasicRectangles<T> result_recs = recs;
+    result_recs += vec;
+    return result_recs;
+}
+
+template <typename T>
+BasicRectangles<T> operator+ (BasicRectangles<T>&& recs, const BasicVector<T>& vec) {
+    return std::move(recs += vec);
+}
+
+template <typename T>
+BasicRectangles<T> operator+ (const BasicVector<T>& vec, const BasicRectangles<T>& recs) {
+    return recs + vec;
+}
+
+template <typename T>
+BasicRectangles<T> operator+ (const BasicVector<T>& vec, BasicRectangles<T>&& recs) {
+    return std::move(recs += vec);
+}
 
 #endif /* GEOMETRY_H */
@@ -0,0 +1,210 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#include "cut_plan.h"
+#include "geometry.h"
+
+/**
+ * Benchmark of the bulk operations of Rectangles against a plain
+ * std::vector<Rectangle>, the layout Rectangles used before.
+ *
+ * Usage: geometry_bench [NUMBER_OF_RECTANGLES]
+ */
+
+namespace {
+
+typedef std::chrono::steady_clock bench_clock;
+
+const int repetitions = 20;
+
+/**
+ * Bounds of the guillotine cutting benchmark, which is quadratic
+ * for the vector.
+ */
+const unsigned int max_cut_rectangles = 200000;
+const int cuts = 20000;
+
+/**
+ * Number of the alternative cut plans evaluated.
+ */
+const int alternatives = 1000;
+
+/**
+ * Number of point-location queries, answered by a scan of the vector.
+ */
+const int queries = 100;
+
+double seconds_since(bench_clock::time_point start) {
+    return std::chrono::duration<double>(bench_clock::now() - start).count();
+}
+
+void report(const char* operation, double vector_time, double rectangles_time) {
+    std::cout << operation << ": vector " << vector_time << " s, Rectangles "
+              << rectangles_time << " s, speedup " << vector_time / rectangles_time << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    unsigned int n = argc > 1 ? std::atoi(argv[1]) : 4000000;
+
+    std::vector<Rectangle> vector_of_rectangles;
+    Rectangles rectangles;
+    vector_of_rectangles.reserve(n);
+    srand(1);
+    for (unsigned int i = 0; i < n; ++i) {
+        Rectangle rec(rand() % 1000, rand() % 1000, Position(rand() % 100000, rand() % 100000));
+        vector_of_rectangles.push_back(rec);
+        rectangles.push_back(rec);
+    }
+    std::vector<Rectangle> vector_copy = vector_of_rectangles;
+    Rectangles rectangles_copy = rectangles;
+    Vector vec(3, -7);
+
+    // Translation
+    bench_clock::time_point start = bench_clock::now();
+    for (int r = 0; r < repetitions; ++r)
+        for (unsigned int i = 0; i < vector_of_rectangles.size(); ++i)
+            vector_of_rectangles[i] += vec;
+    double vector_time = seconds_since(start);
+
+    start = bench_clock::now();
+    for (int r = 0; r < repetitions; ++r)
+        rectangles += vec;
+    report("translation", vector_time, seconds_since(start));
+
+    // Sum of the areas
+    long long vector_sum = 0, rectangles_sum = 0;
+    start = bench_clock::now();
+    for (int r = 0; r < repetitions; ++r)
+        for (unsigned int i = 0; i < vector_of_rectangles.size(); ++i)
+            vector_sum += (long long) vector_of_rectangles[i].width() * vector_of_rectangles[i].height();
+    vector_time = seconds_since(start);
+
+    start = bench_clock::now();
+    for (int r = 0; r < repetitions; ++r)
+        rectangles_sum += rectangles.total_area();
+    report("area sum", vector_time, seconds_since(start));
+
+    // Equality of equal containers, the slowest case
+    int vector_equal = 0, rectangles_equal = 0;
+    for (unsigned int i = 0; i < n; ++i)
+        vector_copy[i] += Vector(3 * repetitions, -7 * repetitions);
+    rectangles_copy += Vector(3 * repetitions, -7 * repetitions);
+
+    start = bench_clock::now();
+    for (int r = 0; r < repetitions; ++r)
+        vector_equal += vector_of_rectangles == vector_copy;
+    vector_time = seconds_since(start);
+
+    start = bench_clock::now();
+    for (int r = 0; r < repetitions; ++r)
+        rectangles_equal += rectangles == rectangles_copy;
+    report("equality", vector_time, seconds_since(start));
+
+    // Guillotine cuts: every cut splits one of the pieces of the previous cut.
+    unsigned int m = n < max_cut_rectangles ? n : max_cut_rectangles;
+    std::vector<Rectangle> vector_pieces(vector_of_rectangles.begin(), vector_of_rectangles.begin() + m);
+    Rectangles pieces;
+    for (unsigned int i = 0; i < m; ++i)
+        pieces.push_back(vector_pieces[i]);
+    std::vector<unsigned int> cut_at(cuts);
+    unsigned int at = m / 2;
+    for (int c = 0; c < cuts; ++c) {
+        at += rand() % 2;
+        cut_at[c] = at;
+    }
+
+    start = bench_clock::now();
+    for (int c = 0; c < cuts; ++c) {
+        std::pair<Rectangle, Rectangle> parts = vector_pieces[cut_at[c]].split_vertically(0);
+        vector_pieces[cut_at[c]] = parts.first;
+        vector_pieces.insert(vector_pieces.begin() + cut_at[c] + 1, parts.second);
+    }
+    vector_time = seconds_since(start);
+
+    start = bench_clock::now();
+    for (int c = 0; c < cuts; ++c)
+        pieces.split_vertically(cut_at[c], 0);
+    report("cuts", vector_time, seconds_since(start));
+
+    // Cut plan: the same cuts of one sheet made by splits of a container,
+    // then by a plan executed at once, then alternatives of the plan
+    // evaluated without building containers.
+    Rectangle sheet(cuts + 1, cuts + 1);
+    std::vector<int> cut_places(cuts);
+    for (int c = 0; c < cuts; ++c)
+        cut_places[c] = rand() % 2;
+
+    start = bench_clock::now();
+    Rectangles sheet_pieces({sheet});
+    for (int c = 0; c < cuts; ++c) {
+        if (c % 2)
+            sheet_pieces.split_horizontally(c, cut_places[c]);
+        else
+            sheet_pieces.split_vertically(c, cut_places[c]);
+    }
+    vector_time = seconds_since(start);
+
+    start = bench_clock::now();
+    CutPlan plan(sheet);
+    unsigned int node = 0;
+    std::vector<unsigned int> plan_nodes;
+    for (int c = 0; c < cuts; ++c) {
+        plan_nodes.push_back(node);
+        node = (c % 2 ? plan.cut_horizontally(node, cut_places[c]) : plan.cut_vertically(node, cut_places[c])).second;
+    }
+    Rectangles plan_pieces = plan.execute();
+    std::cout << "cut plan: splits " << vector_time << " s, plan " << seconds_since(start) << " s" << std::endl;
+
+    start = bench_clock::now();
+    long long best_area = 0;
+    for (int a = 0; a < alternatives; ++a) {
+        CutPlan alternative = plan;
+        alternative.undo(plan_nodes[rand() % cuts]);
+        long long area = 0;
+        alternative.for_each_piece([&area](const Rectangle& rec) {
+            if (rec.width() > 0 && rec.height() > 0)
+                area += rec.area();
+        });
+        best_area = std::max(best_area, area);
+    }
+    std::cout << "cut plan: " << alternatives << " alternatives evaluated in " << seconds_since(start) << " s" << std::endl;
+
+    // Point location: a scan of the vector against the spatial index,
+    // including the time of building the index.
+    std::vector<Position> points;
+    for (int q = 0; q < queries; ++q)
+        points.push_back(Position(rand() % 100000, rand() % 100000));
+    unsigned long long vector_found = 0, rectangles_found = 0;
+
+    start = bench_clock::now();
+    for (const Position& point : points)
+        for (const Rectangle& rec : vector_of_rectangles)
+            vector_found += rec.pos().x() <= point.x() && point.x() <= rec.pos().x() + rec.width() &&
+                            rec.pos().y() <= point.y() && point.y() <= rec.pos().y() + rec.height();
+    vector_time = seconds_since(start);
+
+    start = bench_clock::now();
+    for (const Position& point : points)
+        rectangles_found += rectangles.containing(point).size();
+    report("point location", vector_time, seconds_since(start));
+
+    // Union area of all rectangles, which overlap a lot at this density.
+    start = bench_clock::now();
+    long long covered = rectangles.union_area();
+    std::cout << "union area: " << covered << " of " << rectangles.total_area() << " covered in "
+              << seconds_since(start) << " s" << std::endl;
+
+    Rectangles vector_result;
+    for (const Rectangle& rec : vector_pieces)
+        vector_result.push_back(rec);
+
+    if (!(vector_result == pieces) || !(plan_pieces == sheet_pieces) || best_area != sheet.area() || vector_sum != rectangles_sum || vector_found != rectangles_found || vector_equal != repetitions || rectangles_equal != repetitions) {
+        std::cerr << "Results differ" << std::endl;
+        return 1;
+    }
+    return 0;
+}
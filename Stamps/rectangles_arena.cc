@@ -0,0 +1,43 @@
+#include "rectangles_arena.h"
+
+namespace {
+
+const std::size_t alignment = alignof(std::max_align_t);
+
+}  // namespace
+
+RectanglesArena::RectanglesArena(std::size_t block_size)
+        : current(nullptr), left(0), block_size(block_size) {}
+
+RectanglesArena::~RectanglesArena() {
+    this->release();
+}
+
+void* RectanglesArena::allocate(std::size_t bytes) {
+    bytes = (bytes + alignment - 1) / alignment * alignment;
+    if (bytes > this->block_size) {
+        // Large allocations get a block of their own, so that the rest
+        // of the current block is not wasted.
+        char* block = static_cast<char*>(::operator new(bytes));
+        this->blocks.push_back(block);
+        return block;
+    }
+    if (bytes > this->left) {
+        this->current = static_cast<char*>(::operator new(this->block_size));
+        this->blocks.push_back(this->current);
+        this->left = this->block_size;
+    }
+
+    void* result = this->current;
+    this->current += bytes;
+    this->left -= bytes;
+    return result;
+}
+
+void RectanglesArena::release() {
+    for (char* block : this->blocks)
+        ::operator delete(block);
+    this->blocks.clear();
+    this->current = nullptr;
+    this->left = 0;
+}
@@ -0,0 +1,93 @@
+#ifndef RECTANGLES_ARENA_H
+#define RECTANGLES_ARENA_H
+
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+/**
+ * Memory for many short-lived containers: allocations take consecutive
+ * pieces of large blocks and are never freed one by one. All of them
+ * are freed together by release() or by the destructor, so the
+ * containers using the arena must be destroyed or left unused before.
+ */
+class RectanglesArena
+{
+private:
+    std::vector<char*> blocks;
+    char* current;
+    std::size_t left;
+    std::size_t block_size;
+
+public:
+    /**
+     * @param block_size - bytes taken from the system at once
+     */
+    explicit RectanglesArena(std::size_t block_size = 1 << 20);
+    RectanglesArena(const RectanglesArena&) = delete;
+    RectanglesArena& operator= (const RectanglesArena&) = delete;
+    ~RectanglesArena();
+
+    /**
+     * @return memory for the given number of bytes, aligned for any type
+     */
+    void* allocate(std::size_t);
+
+    /**
+     * Free all memory given by the arena.
+     */
+    void release();
+};
+
+/**
+ * Allocator taking memory from an arena, or from the heap when it has
+ * no arena. Containers moved into others take their arena with them.
+ */
+template <typename T>
+class ArenaAllocator
+{
+private:
+    RectanglesArena* source;
+
+public:
+    typedef T value_type;
+    typedef std::true_type propagate_on_container_move_assignment;
+    typedef std::true_type propagate_on_container_swap;
+
+    ArenaAllocator(RectanglesArena* arena = nullptr) : source(arena) {}
+
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& allocator) : source(allocator.arena()) {}
+
+    /**
+     * @return arena of the allocator, nullptr for the heap
+     */
+    RectanglesArena* arena() const {
+        return this->source;
+    }
+
+    T* allocate(std::size_t n) {
+        if (this->source == nullptr)
+            return static_cast<T*>(::operator new(n * sizeof(T)));
+        return static_cast<T*>(this->source->allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, std::size_t) {
+        if (this->source == nullptr)
+            ::operator delete(p);
+    }
+};
+
+template <typename T, typename U>
+bool operator== (const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) {
+    return a.arena() == b.arena();
+}
+
+template <typename T, typename U>
+bool operator!= (const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) {
+    return !(a == b);
+}
+
+#endif /* RECTANGLES_ARENA_H */
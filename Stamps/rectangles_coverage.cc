@@ -0,0 +1,111 @@
+#include <algorithm>
+#include <cstdint>
+#include "rectangles_coverage.h"
+
+template <typename T>
+BasicRectanglesCoverage<T>::BasicRectanglesCoverage(const BasicRectangles<T>& recs)
+        : BasicRectanglesCoverage(recs.size(), [&recs](unsigned int i) { return recs[i]; }) {}
+
+template <typename T>
+BasicRectanglesCoverage<T>::BasicRectanglesCoverage(unsigned int n, const std::function<BasicRectangle<T>(unsigned int)>& rectangle)
+        : covered(0), covered_twice(0) {
+    struct Event
+    {
+        T x;
+        unsigned int y1, y2;
+        int delta;
+    };
+
+    // Rectangles of zero area cover nothing and are left out.
+    for (unsigned int i = 0; i < n; ++i) {
+        BasicRectangle<T> rec = rectangle(i);
+        if (rec.width() > 0 && rec.height() > 0) {
+            this->ys.push_back(rec.pos().y());
+            this->ys.push_back(rec.pos().y() + rec.height());
+        }
+    }
+    if (this->ys.empty())
+        return;
+
+    std::sort(this->ys.begin(), this->ys.end());
+    this->ys.erase(std::unique(this->ys.begin(), this->ys.end()), this->ys.end());
+
+    // Every rectangle enters the sweep line at its left side
+    // and leaves it at its right side.
+    std::vector<Event> events;
+    for (unsigned int i = 0; i < n; ++i) {
+        BasicRectangle<T> rec = rectangle(i);
+        if (!(rec.width() > 0 && rec.height() > 0))
+            continue;
+
+        unsigned int y1 = std::lower_bound(this->ys.begin(), this->ys.end(), rec.pos().y()) - this->ys.begin();
+        unsigned int y2 = std::lower_bound(this->ys.begin(), this->ys.end(), (T) (rec.pos().y() + rec.height())) - this->ys.begin();
+        events.push_back({rec.pos().x(), y1, y2, 1});
+        events.push_back({(T) (rec.pos().x() + rec.width()), y1, y2, -1});
+    }
+    std::sort(events.begin(), events.end(), [](const Event& a, const Event& b) { return a.x < b.x; });
+
+    unsigned int segments = (unsigned int) this->ys.size() - 1;
+    this->covers.assign(2 * segments - 1, 0);
+    this->once.assign(2 * segments - 1, 0);
+    this->twice.assign(2 * segments - 1, 0);
+    for (unsigned int e = 0; e < events.size(); ++e) {
+        if (e > 0) {
+            AreaType<T> distance = (AreaType<T>) events[e].x - events[e - 1].x;
+            this->covered += this->once[0] * distance;
+            this->covered_twice += this->twice[0] * distance;
+        }
+        this->update(0, 0, segments, events[e].y1, events[e].y2, events[e].delta);
+    }
+}
+
+template <typename T>
+void BasicRectanglesCoverage<T>::update(unsigned int node, unsigned int begin, unsigned int end,
+                                        unsigned int y1, unsigned int y2, int delta) {
+    // The node covers the segments [begin, end), the rectangle [y1, y2).
+    // The left child follows the node and the right one follows the
+    // subtree of the left, so the tree takes 2 * segments - 1 nodes.
+    if (y2 <= begin || end <= y1)
+        return;
+
+    bool leaf = end - begin == 1;
+    unsigned int middle = begin + (end - begin) / 2;
+    unsigned int left = node + 1, right = node + 2 * (middle - begin);
+    if (y1 <= begin && end <= y2) {
+        this->covers[node] += delta;
+    } else {
+        this->update(left, begin, middle, y1, y2, delta);
+        this->update(right, middle, end, y1, y2, delta);
+    }
+
+    // Lengths of the parts of the segment covered by the rectangles
+    // below the node, increased by the covers of the node itself.
+    AreaType<T> length = (AreaType<T>) this->ys[end] - this->ys[begin];
+    AreaType<T> once_below = leaf ? 0 : this->once[left] + this->once[right];
+    AreaType<T> twice_below = leaf ? 0 : this->twice[left] + this->twice[right];
+    if (this->covers[node] >= 2) {
+        this->once[node] = this->twice[node] = length;
+    } else if (this->covers[node] == 1) {
+        this->once[node] = length;
+        this->twice[node] = once_below;
+    } else {
+        this->once[node] = once_below;
+        this->twice[node] = twice_below;
+    }
+}
+
+template <typename T>
+AreaType<T> BasicRectanglesCoverage<T>::union_area() const {
+    return this->covered;
+}
+
+template <typename T>
+AreaType<T> BasicRectanglesCoverage<T>::overlap_area() const {
+    return this->covered_twice;
+}
+
+template class BasicRectanglesCoverage<int16_t>;
+template class BasicRectanglesCoverage<int>;
+template class BasicRectanglesCoverage<int64_t>;
+template class BasicRectanglesCoverage<float>;
+template class BasicRectanglesCoverage<double>;
@@ -0,0 +1,55 @@
+#ifndef RECTANGLES_COVERAGE_H
+#define RECTANGLES_COVERAGE_H
+
+
+#include <functional>
+#include <vector>
+#include "geometry.h"
+
+/**
+ * Areas of the plane covered by the rectangles of a container, computed
+ * in O(n log n) time by a sweep line going along the x axis.
+ *
+ * The sweep keeps a segment tree over the distinct y coordinates of the
+ * rectangles, which knows how long parts of the sweep line are covered
+ * once and at least twice. Between two consecutive x coordinates these
+ * lengths do not change, so the areas grow by them times the distance.
+ */
+template <typename T>
+class BasicRectanglesCoverage
+{
+private:
+    // Sorted distinct y coordinates; leaf j of the tree is the
+    // segment between ys[j] and ys[j + 1].
+    std::vector<T> ys;
+
+    // For every node of the tree: the number of the rectangles covering
+    // its whole segment and not any of its ancestors, the length covered
+    // at least once and at least twice within its segment.
+    std::vector<unsigned int> covers;
+    std::vector<AreaType<T>> once, twice;
+
+    AreaType<T> covered, covered_twice;
+
+    void update(unsigned int, unsigned int, unsigned int, unsigned int, unsigned int, int);
+
+public:
+    explicit BasicRectanglesCoverage(const BasicRectangles<T>&);
+
+    /**
+     * Coverage of n rectangles, the i-th of them returned by rectangle(i).
+     */
+    BasicRectanglesCoverage(unsigned int, const std::function<BasicRectangle<T>(unsigned int)>&);
+
+    /**
+     * @return area covered by at least one rectangle
+     */
+    AreaType<T> union_area() const;
+
+    /**
+     * @return area covered by at least two rectangles
+     */
+    AreaType<T> overlap_area() const;
+};
+
+#endif /* RECTANGLES_COVERAGE_H */
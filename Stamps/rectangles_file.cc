@@ -0,0 +1,356 @@
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <iterator>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "rectangles_coverage.h"
+#include "rectangles_file.h"
+#include "rectangles_index.h"
+
+namespace {
+
+const char magic[8] = {'P', 'R', 'O', 'S', 'T', 'O', 'K', '1'};
+const std::size_t header_size = 24;
+const std::size_t count_offset = 16;
+const std::size_t record_size = 16;
+
+/**
+ * The buffer of a writer is written to the file in pieces of this size.
+ */
+const std::size_t flush_bytes = 64 << 10;
+
+// Numbers are assembled byte by byte, so that the files are the same on
+// every machine; compilers turn this into single loads and stores.
+
+void put_uint32(std::string& out, uint32_t x) {
+    for (int i = 0; i < 4; ++i)
+        out += (char) (x >> (8 * i));
+}
+
+void put_uint64(std::string& out, uint64_t x) {
+    for (int i = 0; i < 8; ++i)
+        out += (char) (x >> (8 * i));
+}
+
+uint32_t get_uint32(const unsigned char* p) {
+    return (uint32_t) p[0] | (uint32_t) p[1] << 8 | (uint32_t) p[2] << 16 | (uint32_t) p[3] << 24;
+}
+
+uint64_t get_uint64(const unsigned char* p) {
+    return (uint64_t) get_uint32(p) | (uint64_t) get_uint32(p + 4) << 32;
+}
+
+void put_varint(std::string& out, uint64_t x) {
+    while (x >= 0x80) {
+        out += (char) (x | 0x80);
+        x >>= 7;
+    }
+    out += (char) x;
+}
+
+/**
+ * Read a varint which has to end before end.
+ * @return whether it is correct
+ */
+bool get_varint(const unsigned char*& p, const unsigned char* end, uint64_t& x) {
+    x = 0;
+    for (int shift = 0; p < end && shift < 64; shift += 7) {
+        unsigned char byte = *p++;
+        x |= (uint64_t) (byte & 0x7f) << shift;
+        if (byte < 0x80)
+            return true;
+    }
+    return false;
+}
+
+uint64_t zigzag(int64_t x) {
+    return ((uint64_t) x << 1) ^ (uint64_t) (x >> 63);
+}
+
+int64_t unzigzag(uint64_t x) {
+    return (int64_t) (x >> 1) ^ -(int64_t) (x & 1);
+}
+
+Rectangle get_record(const unsigned char* p) {
+    return Rectangle((int32_t) get_uint32(p + 8), (int32_t) get_uint32(p + 12),
+                     Position((int32_t) get_uint32(p), (int32_t) get_uint32(p + 4)));
+}
+
+/**
+ * Check the header of the file of the given length.
+ * @return whether it is correct
+ */
+bool check_header(const unsigned char* data, std::size_t length, RectanglesFormat& format, uint64_t& count) {
+    if (length < header_size || std::memcmp(data, magic, sizeof(magic)) != 0)
+        return false;
+
+    format = (RectanglesFormat) get_uint32(data + sizeof(magic));
+    count = get_uint64(data + count_offset);
+    return format == RectanglesFormat::fixed || format == RectanglesFormat::delta;
+}
+
+}  // namespace
+
+RectanglesWriter::RectanglesWriter() : format(RectanglesFormat::fixed), count(0), last_x(0), last_y(0) {}
+
+RectanglesWriter::~RectanglesWriter() {
+    if (this->file.is_open())
+        this->close();
+}
+
+bool RectanglesWriter::open(const std::string& path, RectanglesFormat format) {
+    if (this->file.is_open())
+        this->close();
+
+    this->file.open(path, std::ios::binary | std::ios::trunc);
+    this->format = format;
+    this->count = 0;
+    this->last_x = this->last_y = 0;
+
+    // The number of the rectangles is written again by close.
+    this->buffer.assign(magic, sizeof(magic));
+    put_uint32(this->buffer, (uint32_t) format);
+    put_uint32(this->buffer, 0);
+    put_uint64(this->buffer, 0);
+    return this->file.is_open();
+}
+
+void RectanglesWriter::flush() {
+    this->file.write(this->buffer.data(), this->buffer.size());
+    this->buffer.clear();
+}
+
+void RectanglesWriter::add(const Rectangle& rec) {
+    if (this->format == RectanglesFormat::fixed) {
+        put_uint32(this->buffer, (uint32_t) rec.pos().x());
+        put_uint32(this->buffer, (uint32_t) rec.pos().y());
+        put_uint32(this->buffer, (uint32_t) rec.width());
+        put_uint32(this->buffer, (uint32_t) rec.height());
+    } else {
+        put_varint(this->buffer, zigzag((int64_t) rec.pos().x() - this->last_x));
+        put_varint(this->buffer, zigzag((int64_t) rec.pos().y() - this->last_y));
+        put_varint(this->buffer, (uint32_t) rec.width());
+        put_varint(this->buffer, (uint32_t) rec.height());
+        this->last_x = rec.pos().x();
+        this->last_y = rec.pos().y();
+    }
+    this->count++;
+
+    if (this->buffer.size() >= flush_bytes)
+        this->flush();
+}
+
+bool RectanglesWriter::close() {
+    this->flush();
+    std::string count_bytes;
+    put_uint64(count_bytes, this->count);
+    this->file.seekp(count_offset);
+    this->file.write(count_bytes.data(), count_bytes.size());
+
+    bool written = this->file.good();
+    this->file.close();
+    return written && !this->file.fail();
+}
+
+RectanglesView::RectanglesView() : mapping(nullptr), length(0), records(nullptr), count(0) {}
+
+RectanglesView::~RectanglesView() {
+    this->close();
+}
+
+bool RectanglesView::open(const std::string& path) {
+    this->close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat status;
+    void* mapping = MAP_FAILED;
+    if (fstat(fd, &status) == 0 && status.st_size >= (off_t) header_size)
+        mapping = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED)
+        return false;
+
+    this->mapping = mapping;
+    this->length = status.st_size;
+    const unsigned char* data = static_cast<const unsigned char*>(mapping);
+    RectanglesFormat format;
+    uint64_t count;
+    if (!check_header(data, this->length, format, count) || format != RectanglesFormat::fixed ||
+        count > (unsigned int) -1 || (this->length - header_size) / record_size != count ||
+        (this->length - header_size) % record_size != 0) {
+        this->close();
+        return false;
+    }
+
+    this->records = data + header_size;
+    this->count = (unsigned int) count;
+    return true;
+}
+
+void RectanglesView::close() {
+    if (this->mapping != nullptr)
+        munmap(this->mapping, this->length);
+    this->mapping = nullptr;
+    this->length = 0;
+    this->records = nullptr;
+    this->count = 0;
+    this->index.reset();
+}
+
+unsigned int RectanglesView::size() const {
+    return this->count;
+}
+
+Rectangle RectanglesView::operator[](unsigned int i) const {
+    assert(i < this->count);
+
+    return get_record(this->records + (std::size_t) i * record_size);
+}
+
+long long RectanglesView::total_area() const {
+    long long sum = 0;
+    for (unsigned int i = 0; i < this->count; ++i) {
+        const unsigned char* p = this->records + (std::size_t) i * record_size;
+        sum += (long long) (int32_t) get_uint32(p + 8) * (int32_t) get_uint32(p + 12);
+    }
+    return sum;
+}
+
+std::function<Rectangle(unsigned int)> RectanglesView::rectangle() const {
+    const unsigned char* records = this->records;
+    return [records](unsigned int i) { return get_record(records + (std::size_t) i * record_size); };
+}
+
+const RectanglesIndex& RectanglesView::spatial_index() const {
+    if (!this->index)
+        this->index.reset(new RectanglesIndex(this->count, this->rectangle()));
+    return *this->index;
+}
+
+Rectangle RectanglesView::bounding_box() const {
+    assert(this->count > 0);
+
+    Rectangle first = (*this)[0];
+    int x1 = first.pos().x(), y1 = first.pos().y();
+    int x2 = x1 + first.width(), y2 = y1 + first.height();
+    for (unsigned int i = 1; i < this->count; ++i) {
+        Rectangle rec = (*this)[i];
+        x1 = std::min(x1, rec.pos().x());
+        y1 = std::min(y1, rec.pos().y());
+        x2 = std::max(x2, rec.pos().x() + rec.width());
+        y2 = std::max(y2, rec.pos().y() + rec.height());
+    }
+    return Rectangle(x2 - x1, y2 - y1, Position(x1, y1));
+}
+
+Rectangles RectanglesView::filter(const std::function<bool(const Rectangle&)>& predicate) const {
+    Rectangles result;
+    for (unsigned int i = 0; i < this->count; ++i) {
+        Rectangle rec = (*this)[i];
+        if (predicate(rec))
+            result.push_back(rec);
+    }
+    return result;
+}
+
+bool RectanglesView::operator== (const Rectangles& recs) const {
+    if (this->count != recs.size())
+        return false;
+    for (unsigned int i = 0; i < this->count; ++i)
+        if (!((*this)[i] == recs[i]))
+            return false;
+    return true;
+}
+
+bool operator== (const Rectangles& recs, const RectanglesView& view) {
+    return view == recs;
+}
+
+std::vector<unsigned int> RectanglesView::containing(const Position& pos) const {
+    // Ids in the index are the numbers of the rectangles.
+    std::vector<unsigned int> result = this->spatial_index().containing(pos);
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+std::vector<unsigned int> RectanglesView::overlapping(const Rectangle& rec) const {
+    std::vector<unsigned int> result = this->spatial_index().overlapping(rec);
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+std::vector<unsigned int> RectanglesView::nearest(const Position& pos, unsigned int k) const {
+    return this->spatial_index().nearest(pos, k);
+}
+
+long long RectanglesView::union_area() const {
+    return BasicRectanglesCoverage<int>(this->count, this->rectangle()).union_area();
+}
+
+long long RectanglesView::overlap_area() const {
+    return BasicRectanglesCoverage<int>(this->count, this->rectangle()).overlap_area();
+}
+
+bool RectanglesView::is_tiling() const {
+    if (this->count == 0)
+        return true;
+
+    BasicRectanglesCoverage<int> coverage(this->count, this->rectangle());
+    return coverage.overlap_area() == 0 && coverage.union_area() == this->bounding_box().area();
+}
+
+bool write_rectangles(const Rectangles& recs, const std::string& path, RectanglesFormat format) {
+    RectanglesWriter writer;
+    if (!writer.open(path, format))
+        return false;
+    for (unsigned int i = 0; i < recs.size(); ++i)
+        writer.add(recs[i]);
+    return writer.close();
+}
+
+bool read_rectangles(const std::string& path, Rectangles& recs) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+        return false;
+
+    std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(data.data());
+    const unsigned char* end = p + data.size();
+    RectanglesFormat format;
+    uint64_t count;
+    if (!check_header(p, data.size(), format, count))
+        return false;
+    p += header_size;
+
+    if (format == RectanglesFormat::fixed) {
+        if ((std::size_t) (end - p) / record_size != count || (end - p) % record_size != 0)
+            return false;
+        for (; p < end; p += record_size) {
+            if ((int32_t) get_uint32(p + 8) < 0 || (int32_t) get_uint32(p + 12) < 0)
+                return false;
+            recs.push_back(get_record(p));
+        }
+        return true;
+    }
+
+    int64_t x = 0, y = 0;
+    for (uint64_t i = 0; i < count; ++i) {
+        uint64_t dx, dy, width, height;
+        if (!get_varint(p, end, dx) || !get_varint(p, end, dy) ||
+            !get_varint(p, end, width) || !get_varint(p, end, height) ||
+            width > INT32_MAX || height > INT32_MAX)
+            return false;
+
+        // Coordinates wrap around like the ints they were written from.
+        x = (int32_t) (uint32_t) (x + unzigzag(dx));
+        y = (int32_t) (uint32_t) (y + unzigzag(dy));
+        recs.push_back(Rectangle((int) width, (int) height, Position((int) x, (int) y)));
+    }
+    return p == end;
+}
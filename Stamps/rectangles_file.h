@@ -0,0 +1,198 @@
+#ifndef RECTANGLES_FILE_H
+#define RECTANGLES_FILE_H
+
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "geometry.h"
+
+/**
+ * Binary files of rectangles. A file starts with a header:
+ *   - the magic bytes "PROSTOK1",
+ *   - the format as a 32-bit number and 4 zero bytes,
+ *   - the number of the rectangles as a 64-bit number,
+ * followed by the rectangles in their order. All numbers are little-endian.
+ *
+ * In the fixed format every rectangle is a record of four 32-bit
+ * numbers: x, y, width and height, so the file can be used in place.
+ * In the delta format x and y are zigzag varints of the differences
+ * from the previous rectangle, width and height are varints; files of
+ * tiled layouts are several times smaller, but must be read in order.
+ */
+enum class RectanglesFormat : uint32_t
+{
+    fixed = 0,
+    delta = 1
+};
+
+/**
+ * Writer of a file, adding rectangles one by one.
+ */
+class RectanglesWriter
+{
+private:
+    std::ofstream file;
+    std::string buffer;
+    RectanglesFormat format;
+    uint64_t count;
+    int last_x, last_y;
+
+    void flush();
+
+public:
+    RectanglesWriter();
+    RectanglesWriter(const RectanglesWriter&) = delete;
+    RectanglesWriter& operator= (const RectanglesWriter&) = delete;
+
+    /**
+     * Close the file if it is still open.
+     */
+    ~RectanglesWriter();
+
+    /**
+     * Create the file, replacing an existing one.
+     * @return whether the file was created
+     */
+    bool open(const std::string&, RectanglesFormat = RectanglesFormat::fixed);
+
+    /**
+     * Add the rectangle at the end of the file.
+     */
+    void add(const Rectangle&);
+
+    /**
+     * Write the number of the rectangles and close the file.
+     * @return whether everything was written
+     */
+    bool close();
+};
+
+/**
+ * File in the fixed format mapped into memory, whose rectangles are
+ * read from the mapping when they are needed. The records are not
+ * checked when the file is opened, it has to come from a writer.
+ *
+ * The view is not a Rectangles: a container keeps its coordinates in
+ * separate arrays, while the file keeps them record by record, so it
+ * cannot refer to the mapping. Instead the view has the queries of a
+ * constant container, answered the same way: point-location and
+ * overlap queries use a spatial index built on the first of them.
+ */
+class RectanglesView
+{
+private:
+    void* mapping;
+    std::size_t length;
+    const unsigned char* records;
+    unsigned int count;
+    mutable std::unique_ptr<RectanglesIndex> index;
+
+    const RectanglesIndex& spatial_index() const;
+    std::function<Rectangle(unsigned int)> rectangle() const;
+
+public:
+    RectanglesView();
+    RectanglesView(const RectanglesView&) = delete;
+    RectanglesView& operator= (const RectanglesView&) = delete;
+    ~RectanglesView();
+
+    /**
+     * Map the file, closing the previous one.
+     * @return whether it is a correct file in the fixed format
+     */
+    bool open(const std::string&);
+
+    /**
+     * Unmap the file.
+     */
+    void close();
+
+    /**
+     * @return number of the rectangles in the file
+     */
+    unsigned int size() const;
+
+    /**
+     * @return copy of the rectangle with the given number
+     */
+    Rectangle operator[](unsigned int) const;
+
+    /**
+     * @return sum of the areas of all rectangles
+     */
+    long long total_area() const;
+
+    /**
+     * @return smallest rectangle containing all rectangles of the
+     * non-empty file
+     */
+    Rectangle bounding_box() const;
+
+    /**
+     * @return container of the rectangles satisfying the predicate,
+     * in the same order
+     */
+    Rectangles filter(const std::function<bool(const Rectangle&)>&) const;
+
+    /**
+     * @return whether the container holds the same rectangles in the same order
+     */
+    bool operator== (const Rectangles&) const;
+
+    /**
+     * @return numbers of the rectangles containing the point
+     * (on their boundary too), in increasing order
+     */
+    std::vector<unsigned int> containing(const Position&) const;
+
+    /**
+     * @return numbers of the rectangles whose interior has common
+     * points with the interior of the given rectangle, in increasing order
+     */
+    std::vector<unsigned int> overlapping(const Rectangle&) const;
+
+    /**
+     * @return numbers of at most k rectangles nearest to the point,
+     * the nearest first
+     */
+    std::vector<unsigned int> nearest(const Position&, unsigned int) const;
+
+    /**
+     * @return area covered by the rectangles, counting the parts
+     * covered by several of them once
+     */
+    long long union_area() const;
+
+    /**
+     * @return area covered by at least two rectangles
+     */
+    long long overlap_area() const;
+
+    /**
+     * @return whether the rectangles cover their bounding box and their
+     * interiors have no common points; true for an empty file
+     */
+    bool is_tiling() const;
+};
+
+bool operator== (const Rectangles&, const RectanglesView&);
+
+/**
+ * Write the container to the file.
+ * @return whether everything was written
+ */
+bool write_rectangles(const Rectangles&, const std::string&, RectanglesFormat = RectanglesFormat::fixed);
+
+/**
+ * Add the rectangles of the file, in any format, at the end of the container.
+ * @return whether it is a correct file; otherwise the container
+ * may hold a part of the rectangles
+ */
+bool read_rectangles(const std::string&, Rectangles&);
+
+#endif /* RECTANGLES_FILE_H */
@@ -0,0 +1,331 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <queue>
+#include "rectangles_index.h"
+
+namespace {
+
+/**
+ * Squares of distances overflow long long already for 32-bit coordinates,
+ * so they are computed in long double.
+ */
+template <typename D, typename T>
+long double squared_distance(D px, D py, T x1, T y1, T x2, T y2) {
+    long double dx = std::max(std::max((long double) x1 - px, (long double) px - x2), 0.0L);
+    long double dy = std::max(std::max((long double) y1 - py, (long double) py - y2), 0.0L);
+    return dx * dx + dy * dy;
+}
+
+/**
+ * @return whether the value fits the coordinates of type T
+ */
+template <typename T, typename D>
+bool representable(D value) {
+    return !std::is_integral<T>::value ||
+           ((D) std::numeric_limits<T>::min() <= value && value <= (D) std::numeric_limits<T>::max());
+}
+
+}  // namespace
+
+template <typename T>
+const unsigned int BasicRectanglesIndex<T>::node_capacity;
+
+template <typename T>
+const unsigned int BasicRectanglesIndex<T>::nowhere;
+
+template <typename T>
+typename BasicRectanglesIndex<T>::Box BasicRectanglesIndex<T>::bounding_box(const Box* children, unsigned int n) {
+    Box box = children[0];
+    for (unsigned int i = 1; i < n; ++i) {
+        box.x1 = std::min(box.x1, children[i].x1);
+        box.y1 = std::min(box.y1, children[i].y1);
+        box.x2 = std::max(box.x2, children[i].x2);
+        box.y2 = std::max(box.y2, children[i].y2);
+    }
+    return box;
+}
+
+template <typename T>
+void BasicRectanglesIndex<T>::sort_tile_recursive(std::vector<unsigned int>& order, const std::vector<Box>& items) {
+    // Sort by the centre along x, cut into vertical slices of whole
+    // nodes and sort every slice by the centre along y.
+    auto centre_x = [&items](unsigned int a, unsigned int b) {
+        return (AreaType<T>) items[a].x1 + items[a].x2 < (AreaType<T>) items[b].x1 + items[b].x2;
+    };
+    auto centre_y = [&items](unsigned int a, unsigned int b) {
+        return (AreaType<T>) items[a].y1 + items[a].y2 < (AreaType<T>) items[b].y1 + items[b].y2;
+    };
+
+    unsigned int n = (unsigned int) order.size();
+    unsigned int groups = (n + node_capacity - 1) / node_capacity;
+    unsigned int slices = (unsigned int) std::ceil(std::sqrt((double) groups));
+    unsigned int slice_size = ((groups + slices - 1) / slices) * node_capacity;
+
+    std::sort(order.begin(), order.end(), centre_x);
+    for (unsigned int begin = 0; begin < n; begin += slice_size) {
+        unsigned int end = std::min(n, begin + slice_size);
+        std::sort(order.begin() + begin, order.begin() + end, centre_y);
+    }
+}
+
+template <typename T>
+void BasicRectanglesIndex<T>::build(unsigned int level, std::vector<Box>& items, std::vector<unsigned int>& ids) {
+    Tree& tree = this->trees[level];
+    tree = Tree();
+    unsigned int n = (unsigned int) items.size();
+    if (n == 0)
+        return;
+
+    std::vector<unsigned int> order(n);
+    for (unsigned int i = 0; i < n; ++i)
+        order[i] = i;
+    sort_tile_recursive(order, items);
+    tree.boxes.resize(n);
+    tree.ids.resize(n);
+    tree.removed.assign(n, 0);
+    for (unsigned int i = 0; i < n; ++i) {
+        tree.boxes[i] = items[order[i]];
+        tree.ids[i] = ids[order[i]];
+        this->places[tree.ids[i]] = {level, i};
+    }
+    this->entries += n;
+
+    // Every level groups consecutive children of the level below,
+    // which are ordered with the same method first.
+    for (unsigned int first = 0; first < n; first += node_capacity) {
+        unsigned int count = std::min(node_capacity, n - first);
+        tree.nodes.push_back({bounding_box(&tree.boxes[first], count), first, count});
+    }
+    tree.leaves = (unsigned int) tree.nodes.size();
+
+    unsigned int level_begin = 0;
+    while (tree.nodes.size() - level_begin > 1) {
+        unsigned int level_end = (unsigned int) tree.nodes.size();
+        std::vector<Node> nodes(tree.nodes.begin() + level_begin, tree.nodes.end());
+        std::vector<Box> node_boxes(nodes.size());
+        for (unsigned int i = 0; i < nodes.size(); ++i)
+            node_boxes[i] = nodes[i].box;
+
+        std::vector<unsigned int> node_order(nodes.size());
+        for (unsigned int i = 0; i < nodes.size(); ++i)
+            node_order[i] = i;
+        sort_tile_recursive(node_order, node_boxes);
+        for (unsigned int i = 0; i < nodes.size(); ++i) {
+            tree.nodes[level_begin + i] = nodes[node_order[i]];
+            node_boxes[i] = nodes[node_order[i]].box;
+        }
+
+        for (unsigned int first = 0; first < nodes.size(); first += node_capacity) {
+            unsigned int count = std::min(node_capacity, (unsigned int) nodes.size() - first);
+            tree.nodes.push_back({bounding_box(&node_boxes[first], count), level_begin + first, count});
+        }
+        level_begin = level_end;
+    }
+}
+
+template <typename T>
+void BasicRectanglesIndex<T>::collect(unsigned int levels, std::vector<Box>& items, std::vector<unsigned int>& ids) {
+    for (unsigned int level = 0; level < levels; ++level) {
+        Tree& tree = this->trees[level];
+        for (unsigned int i = 0; i < tree.boxes.size(); ++i) {
+            if (tree.removed[i]) {
+                this->removed--;
+            } else {
+                items.push_back(tree.boxes[i]);
+                ids.push_back(tree.ids[i]);
+            }
+        }
+        this->entries -= (unsigned int) tree.boxes.size();
+        tree = Tree();
+    }
+}
+
+template <typename T>
+BasicRectanglesIndex<T>::BasicRectanglesIndex(const BasicRectangles<T>& recs)
+        : BasicRectanglesIndex(recs.size(), [&recs](unsigned int i) { return recs[i]; }) {}
+
+template <typename T>
+BasicRectanglesIndex<T>::BasicRectanglesIndex(unsigned int n, const std::function<BasicRectangle<T>(unsigned int)>& rectangle)
+        : entries(0), removed(0), shift_x(0), shift_y(0) {
+    std::vector<Box> items(n);
+    std::vector<unsigned int> ids(n);
+    for (unsigned int i = 0; i < n; ++i) {
+        BasicRectangle<T> rec = rectangle(i);
+        items[i] = {rec.pos().x(), rec.pos().y(), (T) (rec.pos().x() + rec.width()), (T) (rec.pos().y() + rec.height())};
+        ids[i] = i;
+    }
+
+    unsigned int level = 0;
+    while (((unsigned long long) 1 << level) < n)
+        level++;
+    this->trees.resize(level + 1);
+    this->places.resize(n);
+    this->build(level, items, ids);
+}
+
+template <typename T>
+void BasicRectanglesIndex<T>::translate(const BasicVector<T>& vec) {
+    this->shift_x += vec.x();
+    this->shift_y += vec.y();
+}
+
+template <typename T>
+void BasicRectanglesIndex<T>::set(unsigned int id, const BasicRectangle<T>& rec) {
+    if (id >= this->places.size())
+        this->places.resize(id + 1, {nowhere, 0});
+    Place& place = this->places[id];
+    if (place.level != nowhere) {
+        this->trees[place.level].removed[place.slot] = 1;
+        this->removed++;
+        place.level = nowhere;
+    }
+
+    // The lowest level which can hold the new entry with the entries
+    // of all levels up to it.
+    unsigned long long count = 1;
+    unsigned int level = 0;
+    for (;; ++level) {
+        if (level == this->trees.size())
+            this->trees.emplace_back();
+        count += this->trees[level].boxes.size();
+        if (count <= (unsigned long long) 1 << level)
+            break;
+    }
+
+    // The index keeps the coordinates from before the translations.
+    AreaType<T> x = (AreaType<T>) rec.pos().x() - this->shift_x;
+    AreaType<T> y = (AreaType<T>) rec.pos().y() - this->shift_y;
+    bool fits = representable<T>(x) && representable<T>(x + rec.width()) &&
+                representable<T>(y) && representable<T>(y + rec.height());
+
+    std::vector<Box> items;
+    std::vector<unsigned int> ids;
+    if (!fits || 2 * this->removed > this->entries) {
+        // Most entries are removed, or the rectangle does not fit the
+        // coordinates before the translations: everything is built again,
+        // in the second case with the translations applied.
+        this->collect((unsigned int) this->trees.size(), items, ids);
+        if (!fits) {
+            for (Box& item : items)
+                item = {(T) (item.x1 + this->shift_x), (T) (item.y1 + this->shift_y),
+                        (T) (item.x2 + this->shift_x), (T) (item.y2 + this->shift_y)};
+            x += this->shift_x;
+            y += this->shift_y;
+            this->shift_x = this->shift_y = 0;
+        }
+        level = 0;
+        while (((unsigned long long) 1 << level) < items.size() + 1)
+            level++;
+    } else {
+        this->collect(level + 1, items, ids);
+    }
+    items.push_back({(T) x, (T) y, (T) (x + rec.width()), (T) (y + rec.height())});
+    ids.push_back(id);
+    this->build(level, items, ids);
+}
+
+template <typename T>
+template <typename P, typename F>
+void BasicRectanglesIndex<T>::search(P predicate, F f) const {
+    std::vector<unsigned int> stack;
+    for (const Tree& tree : this->trees) {
+        if (tree.nodes.empty())
+            continue;
+
+        stack.assign(1, (unsigned int) tree.nodes.size() - 1);
+        while (!stack.empty()) {
+            const Node& node = tree.nodes[stack.back()];
+            bool leaf = stack.back() < tree.leaves;
+            stack.pop_back();
+            if (!predicate(node.box))
+                continue;
+
+            for (unsigned int i = node.first; i < node.first + node.count; ++i) {
+                if (!leaf)
+                    stack.push_back(i);
+                else if (!tree.removed[i] && predicate(tree.boxes[i]))
+                    f(tree.ids[i]);
+            }
+        }
+    }
+}
+
+template <typename T>
+std::vector<unsigned int> BasicRectanglesIndex<T>::containing(const BasicPosition<T>& pos) const {
+    // The index keeps the coordinates from before the translations.
+    AreaType<T> x = (AreaType<T>) pos.x() - this->shift_x;
+    AreaType<T> y = (AreaType<T>) pos.y() - this->shift_y;
+
+    std::vector<unsigned int> result;
+    this->search([x, y](const Box& box) {
+        return box.x1 <= x && x <= box.x2 && box.y1 <= y && y <= box.y2;
+    }, [&result](unsigned int id) { result.push_back(id); });
+    return result;
+}
+
+template <typename T>
+std::vector<unsigned int> BasicRectanglesIndex<T>::overlapping(const BasicRectangle<T>& rec) const {
+    AreaType<T> x1 = (AreaType<T>) rec.pos().x() - this->shift_x;
+    AreaType<T> y1 = (AreaType<T>) rec.pos().y() - this->shift_y;
+    AreaType<T> x2 = x1 + rec.width();
+    AreaType<T> y2 = y1 + rec.height();
+
+    std::vector<unsigned int> result;
+    this->search([x1, y1, x2, y2](const Box& box) {
+        return box.x1 < x2 && x1 < box.x2 && box.y1 < y2 && y1 < box.y2;
+    }, [&result](unsigned int id) { result.push_back(id); });
+    return result;
+}
+
+template <typename T>
+std::vector<unsigned int> BasicRectanglesIndex<T>::nearest(const BasicPosition<T>& pos, unsigned int k) const {
+    AreaType<T> x = (AreaType<T>) pos.x() - this->shift_x;
+    AreaType<T> y = (AreaType<T>) pos.y() - this->shift_y;
+
+    // Best-first search over all trees: nodes and rectangles are taken
+    // in the order of their distance, so the rectangles come out nearest
+    // first. Entries are (distance, (kind, (tree, number))): kind 0 for
+    // a rectangle at position number of the leaves, 1 for a node.
+    typedef std::pair<long double, std::pair<int, std::pair<unsigned int, unsigned int>>> entry;
+    std::priority_queue<entry, std::vector<entry>, std::greater<entry>> queue;
+    std::vector<unsigned int> result;
+    if (k == 0)
+        return result;
+
+    for (unsigned int t = 0; t < this->trees.size(); ++t) {
+        const Tree& tree = this->trees[t];
+        if (tree.nodes.empty())
+            continue;
+        const Box& root = tree.nodes.back().box;
+        queue.push({squared_distance(x, y, root.x1, root.y1, root.x2, root.y2),
+                    {1, {t, (unsigned int) tree.nodes.size() - 1}}});
+    }
+    while (!queue.empty() && result.size() < k) {
+        entry top = queue.top();
+        queue.pop();
+        const Tree& tree = this->trees[top.second.second.first];
+        unsigned int i = top.second.second.second;
+        if (top.second.first == 0) {
+            result.push_back(tree.ids[i]);
+            continue;
+        }
+
+        const Node& node = tree.nodes[i];
+        for (unsigned int c = node.first; c < node.first + node.count; ++c) {
+            if (i < tree.leaves && tree.removed[c])
+                continue;
+            const Box& box = i < tree.leaves ? tree.boxes[c] : tree.nodes[c].box;
+            queue.push({squared_distance(x, y, box.x1, box.y1, box.x2, box.y2),
+                        {i < tree.leaves ? 0 : 1, {top.second.second.first, c}}});
+        }
+    }
+    return result;
+}
+
+template class BasicRectanglesIndex<int16_t>;
+template class BasicRectanglesIndex<int>;
+template class BasicRectanglesIndex<int64_t>;
+template class BasicRectanglesIndex<float>;
+template class BasicRectanglesIndex<double>;
@@ -0,0 +1,137 @@
+#ifndef RECTANGLES_INDEX_H
+#define RECTANGLES_INDEX_H
+
+
+#include <functional>
+#include <vector>
+#include "geometry.h"
+
+/**
+ * Spatial index over the rectangles of a container: packed R-trees
+ * built with the Sort-Tile-Recursive method. Every node holds the
+ * bounding box of up to node_capacity children.
+ *
+ * The index follows the changes of the container with the logarithmic
+ * method. A tree of level k holds at most 2^k rectangles. A rectangle
+ * added or changed is put into a new tree together with the trees of
+ * the lowest levels, so that the new tree fits its level, which takes
+ * O(log^2 n) amortized time. The previous entry of a changed rectangle
+ * is only marked as removed; all trees are built again without such
+ * entries once they make up half of the entries. A query searches each
+ * of the O(log n) trees.
+ *
+ * The rectangles are identified by ids, which the container keeps for
+ * them while they move. Translations of the whole container only shift
+ * the index; a rectangle which does not fit the coordinates from before
+ * the translations makes all trees built again with them applied. Query
+ * coordinates and the shift are computed in AreaType<T>, wider than the
+ * coordinates, and squared distances in long double.
+ */
+template <typename T>
+class BasicRectanglesIndex
+{
+private:
+    struct Box
+    {
+        T x1, y1, x2, y2;
+    };
+
+    struct Node
+    {
+        Box box;
+        unsigned int first, count;
+    };
+
+    struct Tree
+    {
+        // Boxes and ids of the rectangles, in the order of the leaves.
+        std::vector<Box> boxes;
+        std::vector<unsigned int> ids;
+        std::vector<char> removed;
+
+        // Leaves first, the root last. Children of a leaf are boxes,
+        // children of other nodes are nodes of the level below.
+        std::vector<Node> nodes;
+        unsigned int leaves;
+    };
+
+    struct Place
+    {
+        unsigned int level, slot;
+    };
+
+    static const unsigned int node_capacity = 16;
+    static const unsigned int nowhere = ~0u;
+
+    // Trees by their levels, some of them empty.
+    std::vector<Tree> trees;
+    // Entry of every id in the trees, level nowhere if it has none.
+    std::vector<Place> places;
+    unsigned int entries, removed;
+    AreaType<T> shift_x, shift_y;
+
+    static Box bounding_box(const Box*, unsigned int);
+    static void sort_tile_recursive(std::vector<unsigned int>&, const std::vector<Box>&);
+
+    /**
+     * Build the tree of the given level from the boxes and the ids,
+     * replacing the tree there.
+     */
+    void build(unsigned int, std::vector<Box>&, std::vector<unsigned int>&);
+
+    /**
+     * Move the entries which are not removed from the trees of the
+     * levels below the given one to the boxes and the ids.
+     */
+    void collect(unsigned int, std::vector<Box>&, std::vector<unsigned int>&);
+
+    /**
+     * Call f(id) on the rectangles in the subtrees whose box
+     * satisfies the predicate, if their own box does.
+     */
+    template <typename P, typename F>
+    void search(P predicate, F f) const;
+
+public:
+    /**
+     * Index of the rectangles of the container, with their numbers as ids.
+     */
+    explicit BasicRectanglesIndex(const BasicRectangles<T>&);
+
+    /**
+     * Index of n rectangles, the i-th of them returned by rectangle(i),
+     * with their numbers as ids.
+     */
+    BasicRectanglesIndex(unsigned int, const std::function<BasicRectangle<T>(unsigned int)>&);
+
+    /**
+     * Shift the index after the container was moved by the vector.
+     */
+    void translate(const BasicVector<T>&);
+
+    /**
+     * Index the rectangle under the id, in place of the previous
+     * rectangle with this id, if there was one.
+     */
+    void set(unsigned int, const BasicRectangle<T>&);
+
+    /**
+     * @return ids of the rectangles containing the point
+     * (on their boundary too), in no particular order
+     */
+    std::vector<unsigned int> containing(const BasicPosition<T>&) const;
+
+    /**
+     * @return ids of the rectangles whose interior has common points
+     * with the interior of the given rectangle, in no particular order
+     */
+    std::vector<unsigned int> overlapping(const BasicRectangle<T>&) const;
+
+    /**
+     * @return ids of at most k rectangles nearest to the point,
+     * the nearest first; rectangles containing the point are at distance 0
+     */
+    std::vector<unsigned int> nearest(const BasicPosition<T>&, unsigned int) const;
+};
+
+#endif /* RECTANGLES_INDEX_H */
@@ -1,7 +1,30 @@
 #include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
 #include <iostream>
+#include <type_traits>
+#include "cut_plan.h"
 #include "geometry.h"
+#include "rectangles_file.h"
 
+// Value types are trivially copyable and usable at compile time.
+static_assert(std::is_trivially_copyable<Position>::value, "Position is not trivially copyable");
+static_assert(std::is_trivially_copyable<Vector>::value, "Vector is not trivially copyable");
+static_assert(std::is_trivially_copyable<Rectangle>::value, "Rectangle is not trivially copyable");
+
+constexpr Rectangle compile_time_rectangle(10, 4, Position(1, 2));
+static_assert(compile_time_rectangle.area() == 40, "constexpr area");
+static_assert(compile_time_rectangle.reflection() == Rectangle(4, 10, Position(2, 1)), "constexpr reflection");
+static_assert(compile_time_rectangle + Vector(1, 1) == Rectangle(10, 4, Position(2, 3)), "constexpr translation");
+static_assert(compile_time_rectangle.split_vertically(3).second == Rectangle(7, 4, Position(4, 2)), "constexpr split");
+static_assert(compile_time_rectangle.split_horizontally(1).second == Rectangle(10, 3, Position(1, 3)), "constexpr split");
+static_assert(merge_horizontally(compile_time_rectangle.split_horizontally(1).first,
+                                 compile_time_rectangle.split_horizontally(1).second) == compile_time_rectangle,
+              "constexpr merge");
+static_assert(merge_vertically(compile_time_rectangle.split_vertically(3).first,
+                               compile_time_rectangle.split_vertically(3).second) == compile_time_rectangle,
+              "constexpr merge");
 
 int main() {
 //poczatek Position
@@ -171,6 +194,380 @@ int main() {
 	}
 //koniec Merge
 
+//poczatek Bulk
+	{
+		Rectangles rectangles;
+		for (int i = 0; i < 1000; i++)
+			rectangles.push_back(Rectangle(i, 50000, Position(i, -i)));
+		assert(rectangles.size() == 1000);
+		assert(rectangles.total_area() == 50000LL * 999 * 1000 / 2);
+
+		Rectangles moved = rectangles + Vector(5, 5);
+		assert(!(moved == rectangles));
+		moved += Vector(-5, -5);
+		assert(moved == rectangles);
+
+		moved[3] = Rectangle(1, 1);
+		assert(moved[3] == Rectangle(1, 1));
+		assert(rectangles[3] == Rectangle(3, 50000, Position(3, -3)));
+		moved[4] += Vector(1, 2);
+		assert(moved[4].pos() == Position(5, -2));
+		assert(moved[4].area() == 4 * 50000);
+	}
+//koniec Bulk
+
+//poczatek Splits
+	{
+		Rectangles strips({Rectangle(100, 10), Rectangle(100, 10, Position(0, 10))});
+		for (int i = 0; i < 99; i++)
+			strips.split_vertically(i, 1);
+		assert(strips.size() == 101);
+		for (int i = 0; i < 100; i++)
+			assert(strips[i] == Rectangle(1, 10, Position(i, 0)));
+		assert(strips[100] == Rectangle(100, 10, Position(0, 10)));
+
+		strips.split_horizontally(0, 4);
+		strips.push_back(Rectangle(1, 1));
+		assert(strips.size() == 103);
+		assert(strips[0] == Rectangle(1, 4));
+		assert(strips[1] == Rectangle(1, 6, Position(0, 4)));
+		assert(strips[2] == Rectangle(1, 10, Position(1, 0)));
+		assert(strips[102] == Rectangle(1, 1));
+		assert(strips.total_area() == 2001);
+	}
+//koniec Splits
+
+//poczatek Index
+	{
+		Rectangles grid;
+		for (int i = 0; i < 50; i++)
+			for (int j = 0; j < 50; j++)
+				grid.push_back(Rectangle(2, 2, Position(2 * i, 2 * j)));
+		assert(grid.containing(Position(3, 3)) == std::vector<unsigned int>({51}));
+		assert(grid.containing(Position(2, 2)) == std::vector<unsigned int>({0, 1, 50, 51}));
+		assert(grid.containing(Position(-1, 0)).empty());
+		assert(grid.overlapping(Rectangle(2, 1, Position(1, 1))) == std::vector<unsigned int>({0, 50}));
+		assert(grid.overlapping(Rectangle(2, 2, Position(100, 0))).empty());
+		assert(grid.nearest(Position(105, 1), 1) == std::vector<unsigned int>({2450}));
+
+		grid += Vector(1, 1);
+		assert(grid.containing(Position(4, 4)) == std::vector<unsigned int>({51}));
+		grid.split_vertically(0, 1);
+		assert(grid.containing(Position(4, 4)) == std::vector<unsigned int>({52}));
+		assert(grid.containing(Position(1, 2)) == std::vector<unsigned int>({0}));
+		grid[0] += Vector(-10, 0);
+		assert(grid.containing(Position(1, 2)).empty());
+		assert(grid.nearest(Position(-9, 1), 2) == std::vector<unsigned int>({0, 2}));
+
+		// The index follows cuts and moves made between the queries.
+		Rectangles sheet = {Rectangle(1000, 1000)};
+		for (int i = 0; i < 2000; i++) {
+			unsigned int idx = (i * 7919u) % sheet.size();
+			Rectangle rec = sheet[idx];
+			if (i % 3 == 0 && rec.width() > 1)
+				sheet.split_vertically(idx, rec.width() / 2);
+			else if (i % 3 == 1 && rec.height() > 1)
+				sheet.split_horizontally(idx, rec.height() / 2);
+			else
+				sheet[idx] += Vector(i % 5 - 2, i % 7 - 3);
+
+			Position point((i * 37) % 1000, (i * 61) % 1000);
+			std::vector<unsigned int> expected;
+			for (unsigned int j = 0; j < sheet.size(); j++)
+				if (sheet[j].pos().x() <= point.x() && point.x() <= sheet[j].pos().x() + sheet[j].width() &&
+				    sheet[j].pos().y() <= point.y() && point.y() <= sheet[j].pos().y() + sheet[j].height())
+					expected.push_back(j);
+			assert(sheet.containing(point) == expected);
+		}
+
+		// Distances and translations beyond the range of the coordinates.
+		Rectangles corners({Rectangle(1, 1, Position(-2000000000, -2000000000)), Rectangle(1, 1, Position(0, 2000000000))});
+		assert(corners.nearest(Position(2100000000, 2100000000), 2) == std::vector<unsigned int>({1, 0}));
+		corners += Vector(2000000000, 0);
+		corners[1] = Rectangle(1, 1, Position(-2000000000, 5));
+		assert(corners.containing(Position(0, -2000000000)) == std::vector<unsigned int>({0}));
+		assert(corners.containing(Position(-2000000000, 5)) == std::vector<unsigned int>({1}));
+		assert(corners.overlapping(Rectangle(2000000000, 2000000000, Position(-2000000000, -10))) == std::vector<unsigned int>({1}));
+	}
+//koniec Index
+
+//poczatek Offset
+	{
+		Rectangles moved({Rectangle(4, 2), Rectangle(1, 1, Position(5, 5))});
+		moved += Vector(10, -3);
+		moved.push_back(Rectangle(2, 2));
+		moved[0] = Rectangle(4, 2, Position(1, 1));
+		moved.split_vertically(1, 0);
+		assert(moved[0] == Rectangle(4, 2, Position(1, 1)));
+		assert(moved[1] == Rectangle(0, 1, Position(15, 2)));
+		assert(moved[2] == Rectangle(1, 1, Position(15, 2)));
+		assert(moved[3].pos() == Position(0, 0));
+		assert(moved == Rectangles({Rectangle(4, 2, Position(1, 1)), Rectangle(0, 1, Position(15, 2)),
+		                            Rectangle(1, 1, Position(15, 2)), Rectangle(2, 2)}));
+
+		Rectangles apart({Rectangle(1, 1, Position(-2000000000, 0))});
+		apart += Vector(2000000000, 0);
+		apart += Vector(2000000000, 1);
+		assert(apart[0].pos() == Position(2000000000, 1));
+		apart[0] = Rectangle(1, 1, Position(-2000000000, 0));
+		apart.push_back(Rectangle(2, 2, Position(-1999999999, -1)));
+		assert(apart[0].pos() == Position(-2000000000, 0));
+		assert(apart.bounding_box() == Rectangle(3, 2, Position(-2000000000, -1)));
+		assert(apart + Vector(-100, 0) == Rectangles({Rectangle(1, 1, Position(-2000000100, 0)), Rectangle(2, 2, Position(-2000000099, -1))}));
+
+		BasicRectangles<float> fine;
+		for (int j = 0; j < 100; j++)
+			fine.push_back(BasicRectangle<float>(1, 1));
+		fine += BasicVector<float>(1000, 0);
+		for (int j = 0; j < 100; j++)
+			fine[j] = BasicRectangle<float>(1, 1, BasicPosition<float>(j * 0.001f, j * 0.1f));
+		for (int j = 0; j < 100; j++)
+			assert(fine[j].pos() == BasicPosition<float>(j * 0.001f, j * 0.1f));
+		fine += BasicVector<float>(-0.5f, 0);
+		fine[1] += BasicVector<float>(0.001f, 0);
+		assert(fine[1].pos().x() == (0.001f - 0.5f) + 0.001f);
+
+		BasicRectangles<double> huge({BasicRectangle<double>(1, 1)});
+		huge += BasicVector<double>(1e17, 0);
+		huge.push_back(BasicRectangle<double>(1, 1, BasicPosition<double>(3, 0)));
+		huge[0] = BasicRectangle<double>(1, 1, BasicPosition<double>(0.3, 0));
+		assert(huge[0].pos().x() == 0.3 && huge[1].pos().x() == 3);
+	}
+//koniec Offset
+
+//poczatek Move
+	{
+		Rectangles source({Rectangle(1, 2), Rectangle(3, 4)});
+		Rectangles moved(std::move(source));
+		assert(source.size() == 0);
+		assert(moved == Rectangles({Rectangle(1, 2), Rectangle(3, 4)}));
+		source.push_back(Rectangle(5, 6));
+		assert(source == Rectangles({Rectangle(5, 6)}));
+
+		Rectangles sum = std::move(moved) + Vector(1, 1);
+		assert(sum == Rectangles({Rectangle(1, 2, Position(1, 1)), Rectangle(3, 4, Position(1, 1))}));
+		sum = std::move(source);
+		assert(sum == Rectangles({Rectangle(5, 6)}));
+
+		RectanglesArena arena(64);
+		{
+			Rectangles frame(arena);
+			for (int i = 0; i < 100; i++)
+				frame.push_back(Rectangle(i, 1));
+			frame.split_vertically(0, 0);
+			Rectangles copy = frame;
+			assert(copy == frame && copy.size() == 101);
+			sum = std::move(frame);
+			assert(sum == copy);
+		}
+		sum = Rectangles();
+		arena.release();
+	}
+//koniec Move
+
+//poczatek Parallel
+	{
+		Rectangles many, same;
+		long long area = 0;
+		for (int i = 0; i < 1000000; i++) {
+			Rectangle rec(i % 7, i % 5, Position(i % 1000 - 500, i / 1000));
+			many.push_back(rec);
+			same.push_back(rec + Vector(1, 0));
+			area += rec.area();
+		}
+		same.split_vertically(500000, 0);
+		same += Vector(-1, 0);
+		assert(!(many == same));
+		assert(many.total_area() == area && same.total_area() == area);
+		assert(many.bounding_box() == Rectangle(1005, 1003, Position(-500, 0)));
+
+		Rectangles wide = many.filter([](const Rectangle& rec) { return rec.width() == 6; });
+		assert(wide.size() == 142857);
+		assert(wide[0] == Rectangle(6, 1, Position(-494, 0)));
+		assert(wide.bounding_box() == Rectangle(1005, 1003, Position(-500, 0)));
+		assert(many.filter([](const Rectangle&) { return false; }).size() == 0);
+
+		Rectangles copy = many;
+		assert(copy == many);
+		copy[999999] += Vector(0, 1);
+		assert(!(copy == many));
+	}
+//koniec Parallel
+
+//poczatek Coalesce
+	{
+		Rectangles pieces({Rectangle(100, 10, Position(5, 5)), Rectangle(3, 3)});
+		for (int i = 0; i < 99; i++)
+			pieces.split_vertically(i, 1);
+		for (int i = 0; i < 100; i += 2)
+			pieces.split_horizontally(i + i / 2, 4);
+		assert(pieces.size() == 151);
+		pieces += Vector(-5, -5);
+		pieces.coalesce();
+		assert(pieces == Rectangles({Rectangle(100, 10), Rectangle(3, 3, Position(-5, -5))}));
+
+		// Pieces of a guillotine cut are merged in the reverse order.
+		Rectangles quarters({Rectangle(2, 1), Rectangle(1, 1, Position(0, 1)), Rectangle(1, 1, Position(1, 1))});
+		quarters.coalesce();
+		assert(quarters == Rectangles({Rectangle(2, 2)}));
+
+		Rectangles pinwheel({Rectangle(2, 1), Rectangle(1, 2, Position(2, 0)), Rectangle(2, 1, Position(1, 2)),
+		                     Rectangle(1, 2, Position(0, 1)), Rectangle(1, 1, Position(1, 1))});
+		Rectangles same = pinwheel;
+		pinwheel.coalesce();
+		assert(pinwheel == same);
+	}
+//koniec Coalesce
+
+//poczatek CutPlan
+	{
+		Rectangle sheet(10, 6, Position(1, 1));
+		CutPlan plan(sheet);
+		std::pair<unsigned int, unsigned int> halves = plan.cut_vertically(0, 4);
+		std::pair<unsigned int, unsigned int> right = plan.cut_horizontally(halves.second, 2);
+		plan.cut_vertically(right.second, 3);
+		assert(plan.size() == 4);
+		assert(!plan.is_leaf(0) && plan.is_leaf(halves.first));
+		assert(plan.piece(right.first) == Rectangle(6, 2, Position(5, 1)));
+
+		Rectangles by_splits({sheet});
+		by_splits.split_vertically(0, 4);
+		by_splits.split_horizontally(1, 2);
+		by_splits.split_vertically(2, 3);
+		assert(plan.execute() == by_splits);
+
+		long long area = 0;
+		plan.for_each_piece([&area](const Rectangle& rec) { area += rec.area(); });
+		assert(area == sheet.area());
+
+		CutPlan alternative = plan;
+		alternative.undo(halves.second);
+		assert(alternative.size() == 2 && plan.size() == 4);
+		std::pair<unsigned int, unsigned int> again = alternative.cut_horizontally(halves.second, 5);
+		assert(alternative.piece(again.second) == Rectangle(6, 1, Position(5, 6)));
+		assert(alternative.execute() == Rectangles({Rectangle(4, 6, Position(1, 1)), Rectangle(6, 5, Position(5, 1)),
+		                                            Rectangle(6, 1, Position(5, 6))}));
+
+		alternative.undo(0);
+		assert(alternative.size() == 1 && alternative.execute() == Rectangles({sheet}));
+	}
+//koniec CutPlan
+
+//poczatek File
+	{
+		Rectangles layout({Rectangle(3, 4, Position(-7, 2)), Rectangle(0, 1, Position(2147483647, -2147483647 - 1))});
+		for (int i = 0; i < 10000; i++)
+			layout.push_back(Rectangle(i % 10, 1, Position(i % 100, i / 100)));
+		std::string fixed_path = "/tmp/prostokaty_fixed.bin", delta_path = "/tmp/prostokaty_delta.bin";
+		assert(write_rectangles(layout, fixed_path));
+		assert(write_rectangles(layout, delta_path, RectanglesFormat::delta));
+
+		Rectangles fixed_read, delta_read;
+		assert(read_rectangles(fixed_path, fixed_read) && fixed_read == layout);
+		assert(read_rectangles(delta_path, delta_read) && delta_read == layout);
+
+		RectanglesView view;
+		assert(view.open(fixed_path) && view.size() == layout.size());
+		assert(view[1] == layout[1] && view[10001] == layout[10001]);
+		assert(view.total_area() == layout.total_area());
+		assert(view == layout && layout == view && !(view == fixed_read.filter([](const Rectangle& rec) { return rec.width() > 0; })));
+		assert(view.filter([](const Rectangle& rec) { return rec.width() > 0; }) == layout.filter([](const Rectangle& rec) { return rec.width() > 0; }));
+		assert(view.containing(Position(5, 5)) == layout.containing(Position(5, 5)));
+		assert(view.overlapping(Rectangle(10, 10, Position(-5, 0))) == layout.overlapping(Rectangle(10, 10, Position(-5, 0))));
+		assert(view.nearest(Position(-20, 3), 1) == std::vector<unsigned int>({0}));
+		assert(view.union_area() == layout.union_area() && view.overlap_area() == layout.overlap_area());
+		assert(!view.is_tiling());
+		assert(!view.open(delta_path) && view.size() == 0);
+
+		RectanglesWriter writer;
+		assert(writer.open(delta_path, RectanglesFormat::delta));
+		writer.close();
+		Rectangles empty;
+		assert(read_rectangles(delta_path, empty) && empty.size() == 0);
+		assert(!read_rectangles("/tmp/nie_ma_takiego_pliku.bin", empty));
+		std::remove(fixed_path.c_str());
+		std::remove(delta_path.c_str());
+	}
+//koniec File
+
+//poczatek Coordinates
+	{
+		assert(Rectangle(100000, 100000).area() == 10000000000LL);
+
+		BasicRectangles<int16_t> small({BasicRectangle<int16_t>(300, 300), BasicRectangle<int16_t>(10, 20, BasicPosition<int16_t>(-5, 7))});
+		small.split_vertically(0, 100);
+		small += BasicVector<int16_t>(1, 1);
+		assert(small.size() == 3 && small.total_area() == 90200);
+		assert(small[1] == BasicRectangle<int16_t>(200, 300, BasicPosition<int16_t>(101, 1)));
+		assert(small.containing(BasicPosition<int16_t>(101, 1)) == std::vector<unsigned int>({0, 1}));
+
+		int64_t far = (int64_t) 1 << 40;
+		BasicRectangles<int64_t> wide({BasicRectangle<int64_t>(3000000000LL, 3000000000LL, BasicPosition<int64_t>(far, -far))});
+		wide.split_horizontally(0, 1000000000LL);
+		assert(wide.total_area() == 9000000000000000000LL);
+		assert(wide[1].pos() == BasicPosition<int64_t>(far, 1000000000LL - far));
+		assert(wide.bounding_box() == BasicRectangle<int64_t>(3000000000LL, 3000000000LL, BasicPosition<int64_t>(far, -far)));
+		wide.push_back(BasicRectangle<int64_t>(far, far, BasicPosition<int64_t>(-far, 0)));
+		wide.push_back(BasicRectangle<int64_t>(far, far, BasicPosition<int64_t>(-far / 2, 0)));
+#ifdef __SIZEOF_INT128__
+		assert(wide[2].area() == (__int128) 1 << 80);
+		assert(wide.total_area() == ((__int128) 1 << 81) + 9000000000000000000LL);
+		assert(wide.union_area() == ((__int128) 3 << 79) + 9000000000000000000LL);
+		assert(wide.overlap_area() == (__int128) 1 << 79);
+#else
+		assert(wide[2].area() == std::ldexp(1.0L, 80));
+		assert(wide.overlap_area() == std::ldexp(1.0L, 79));
+#endif
+
+		BasicRectangles<double> exact({BasicRectangle<double>(1.5, 2, BasicPosition<double>(0.25, 0))});
+		exact.split_vertically(0, 0.5);
+		exact.split_horizontally(1, 0.75);
+		assert(exact.total_area() == 3);
+		assert(exact.nearest(BasicPosition<double>(3, 0.5), 1) == std::vector<unsigned int>({1}));
+		exact.coalesce();
+		assert(exact.size() == 1 && exact[0] == BasicRectangle<double>(1.5, 2, BasicPosition<double>(0.25, 0)));
+		assert(exact + BasicVector<double>(0.5, 0.5) == BasicRectangles<double>({BasicRectangle<double>(1.5, 2, BasicPosition<double>(0.75, 0.5))}));
+	}
+//koniec Coordinates
+
+//poczatek Coverage
+	{
+		Rectangles empty;
+		assert(empty.union_area() == 0 && empty.overlap_area() == 0 && empty.is_tiling());
+
+		Rectangles crossed({Rectangle(4, 2, Position(0, 1)), Rectangle(2, 4, Position(1, 0)), Rectangle(1, 1, Position(1, 1))});
+		assert(crossed.total_area() == 17);
+		assert(crossed.union_area() == 12);
+		assert(crossed.overlap_area() == 4);
+		assert(!crossed.is_tiling());
+
+		Rectangles tiles({Rectangle(6, 4, Position(-3, 2))});
+		tiles.split_vertically(0, 2);
+		tiles.split_horizontally(1, 1);
+		tiles.push_back(Rectangle(0, 3, Position(0, 3)));
+		tiles += Vector(100, -100);
+		assert(tiles.is_tiling() && tiles.union_area() == 24 && tiles.overlap_area() == 0);
+		tiles[2] += Vector(0, 1);
+		assert(!tiles.is_tiling() && tiles.union_area() == 24 && tiles.overlap_area() == 0);
+		tiles[2] += Vector(0, -2);
+		assert(!tiles.is_tiling() && tiles.union_area() == 20 && tiles.overlap_area() == 4);
+
+		Rectangles far({Rectangle(100000, 100000, Position(-50000, 0)), Rectangle(100000, 100000, Position(0, 50000))});
+		assert(far.union_area() == 17500000000LL && far.overlap_area() == 2500000000LL);
+
+		BasicRectangles<double> halves({BasicRectangle<double>(0.5, 1), BasicRectangle<double>(0.5, 1, BasicPosition<double>(0.5, 0))});
+		assert(halves.is_tiling() && halves.union_area() == 1);
+
+		BasicRectangles<double> tenths;
+		for (int i = 0; i < 10; i++)
+			for (int j = 0; j < 10; j++)
+				tenths.push_back(BasicRectangle<double>(0.1, 0.1, BasicPosition<double>(i * 0.1, j * 0.1)));
+		assert(tenths.is_tiling());
+		tenths[37] += BasicVector<double>(0.05, 0);
+		assert(!tenths.is_tiling());
+	}
+//koniec Coverage
+
 	// moje testy - Michal
 
 	Rectangles zestaw {Rectangle(1, 2), Rectangle(3, 5)};